@@ -9,6 +9,13 @@
 #include "api.h"
 
 #include <sys/stat.h>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include <imtjson/string.h>
 #include <imtjson/array.h>
@@ -230,55 +237,76 @@ static Value fetchPage(AbstractBrokerAPI &handler, const Value &req) {
 
 
 Value handleSubaccount(AbstractBrokerAPI &handler, const Value &req) {
-	static std::unordered_map<Value, std::unique_ptr<AbstractBrokerAPI> > subList;
+	static std::unordered_map<Value, std::shared_ptr<AbstractBrokerAPI> > subList;
+	//requests can be processed concurrently (tagged protocol). The lock protects the
+	//list only, it is not held while the request is processed
+	static std::mutex subLock;
 	if (req.hasValue()) {
 		Value id = req[0];
 		Value cmd = req[1];
 		StrViewA cmdstr = cmd.getString();
 		Value args = req[2];
-		bool loadK = false;
-		if (cmdstr == "erase") {
-			subList.erase(id);
-			return Value();
-		} else {
+		std::shared_ptr<AbstractBrokerAPI> p;
+		{
+			std::lock_guard<std::mutex> _(subLock);
+			if (cmdstr == "erase") {
+				subList.erase(id);
+				return Value();
+			}
 			auto iter = subList.find(id);
 			if (iter == subList.end()) {
-				std::unique_ptr<AbstractBrokerAPI> newptr(handler.createSubaccount(handler.secure_storage_path+"-"+id.toString().c_str()));
+				std::shared_ptr<AbstractBrokerAPI> newptr(handler.createSubaccount(handler.secure_storage_path+"-"+id.toString().c_str()));
 				if (newptr == nullptr) throw std::runtime_error("Subaccounts are not supported");
+				//the stream is set once, requests of the subaccount can run concurrently
+				newptr->logStream = handler.logStream;
+				newptr->loadKeys();
+				newptr->flushMessages();
 				iter = subList.emplace(id, std::move(newptr)).first;
-				loadK = true;
-			}
-
-			auto &p = iter->second;
-
-			class LogCleanup{
-			public:
-				decltype(p) z;
-				LogCleanup(decltype(p) z):z(z) {}
-				~LogCleanup() {z->logStream = nullptr;}
-			};
-
-			p->logStream = handler.logStream;
-			LogCleanup cleanUp(p);
-
-			p->flushMessages();
-			if (loadK) p->loadKeys();
-			if (cmdstr == "getBrokerInfo") {
-				Value v = getBrokerInfo(*iter->second, args);
-				return v.replace("subaccounts", false);
-			} else if (cmdstr == "subaccount") {
-				throw std::runtime_error("Can't access subaccount under subaccount");
-			} else {
-				Value v =  p->callMethod(cmdstr, args);
-				if (v[0].getBool()) return v[1]; else throw v[1];
 			}
+			p = iter->second;
+		}
 
+		if (cmdstr == "getBrokerInfo") {
+			Value v = getBrokerInfo(*p, args);
+			return v.replace("subaccounts", false);
+		} else if (cmdstr == "subaccount") {
+			throw std::runtime_error("Can't access subaccount under subaccount");
+		} else {
+			Value v =  p->callMethod(cmdstr, args);
+			if (v[0].getBool()) return v[1]; else throw v[1];
 		}
 	} else {
+		std::lock_guard<std::mutex> _(subLock);
 		return Value(json::array,subList.begin(), subList.end(), [&](const auto &p) {return p.first;});
 	}
 }
 
+static Value batch(AbstractBrokerAPI &handler, const Value &req) {
+	Array response;
+	response.reserve(req.size());
+	for (Value r: req) {
+		StrViewA cmd = r[0].getString();
+		if (cmd == "batch" || cmd == "getMarketSnapshot" || cmd == "subaccount") {
+			response.push_back({false, "Command is not allowed in the batch"});
+		} else {
+			response.push_back(handler.callMethod(cmd, r[1]));
+		}
+	}
+	return response;
+}
+
+static Value getMarketSnapshot(AbstractBrokerAPI &handler, const Value &req) {
+	std::vector<std::string> pairs;
+	for (Value p: req["pairs"]) pairs.push_back(p.toString().c_str());
+	//failed snapshot is not fatal, the requests are processed as a normal batch
+	try {
+		handler.prepareSnapshot(pairs);
+	} catch (std::exception &e) {
+		ondra_shared::logError("Market snapshot failed: $1", e.what());
+	}
+	return batch(handler, req["requests"]);
+}
+
 ///Handler function
 using HandlerFn = Value (*)(AbstractBrokerAPI &handler, const Value &request);
 using MethodMap = ondra_shared::linear_map<std::string_view, HandlerFn> ;
@@ -302,7 +330,9 @@ static MethodMap methodMap ({
 			{"restoreSettings",&restoreSettings},
 			{"fetchPage",&fetchPage},
 			{"subaccount",&handleSubaccount},
-			{"getMarkets",&getMarkets}
+			{"getMarkets",&getMarkets},
+			{"batch",&batch},
+			{"getMarketSnapshot",&getMarketSnapshot}
 	});
 
 
@@ -320,9 +350,69 @@ Value AbstractBrokerAPI::callMethod(std::string_view name, Value args) {
 
 
 
+///Writes message to the output
+/**
+ * @param v message
+ * @param output output stream
+ * @param binary true to use binary framing - 4 bytes of length (little endian) followed
+ * by binary serialized JSON. Otherwise the message is written as text followed by new line
+ */
+static void writeMessage(const Value &v, std::ostream &output, bool binary) {
+	if (binary) {
+		std::string buff;
+		v.serializeBinary([&](char c){buff.push_back(c);}, compressKeys);
+		std::uint32_t len = buff.length();
+		for (int i = 0; i < 4; i++) output.put(static_cast<char>((len >> (i*8)) & 0xFF));
+		output.write(buff.data(), buff.length());
+		output.flush();
+	} else {
+		v.toStream(output);
+		output << std::endl;
+	}
+}
+
+///Reads message from the input
+/**
+ * @param input input stream
+ * @param binary true to use binary framing
+ * @param out message
+ * @retval true message read
+ * @retval false end of stream
+ */
+static bool readMessage(std::istream &input, bool binary, Value &out) {
+	if (binary) {
+		std::uint32_t len = 0;
+		for (int i = 0; i < 4; i++) {
+			int c = input.get();
+			if (c == EOF) return false;
+			len |= static_cast<std::uint32_t>(c & 0xFF) << (i*8);
+		}
+		std::string buff(len, 0);
+		input.read(buff.data(), len);
+		if (input.gcount() != static_cast<std::streamsize>(len)) return false;
+		std::size_t pos = 0;
+		out = Value::parseBinary([&]{
+			if (pos >= buff.length()) throw std::runtime_error("Unexpected end of message");
+			return static_cast<int>(static_cast<unsigned char>(buff[pos++]));
+		}, base64);
+		return true;
+	} else {
+		int i = input.get();
+		while (i != EOF && isspace(i)) i = input.get();
+		if (i == EOF) return false;
+		input.putback(i);
+		out = Value::fromStream(input);
+		return true;
+	}
+}
+
 void AbstractBrokerAPI::dispatch(std::istream& input, std::ostream& output, std::ostream &error, AbstractBrokerAPI &handler) {
 
 	handler.logProvider->setDefault();
+	//binary framing is negotiated by the command "binary". Response is still sent as text,
+	//then both sides use binary framing
+	bool binary = false;
+	bool tagged = false;
 	try {
 		Value v = Value::fromStream(input);
 		handler.logStream = &error;
@@ -330,24 +420,147 @@ void AbstractBrokerAPI::dispatch(std::istream& input, std::ostream& output, std:
 		handler.loadKeys();
 		handler.onInit();
 		while (true) {
-			handler.callMethod(v[0].getString(), v[1]).toStream(output);
+			if (v[0].getString() == "binary") {
+				writeMessage({true, v[1].getBool()}, output, binary);
+				binary = v[1].getBool();
+			} else if (v[0].getString() == "tagged") {
+				tagged = v[1].getBool();
+				writeMessage({true, tagged}, output, binary);
+				if (tagged) {
+					//responses are read continuously, log messages can be written directly
+					dispatchTagged(input, output, handler, binary);
+					break;
+				}
+			} else {
+				writeMessage(handler.callMethod(v[0].getString(), v[1]), output, binary);
+			}
 			handler.logStream = nullptr;
-			output << std::endl;
-			int i = input.get();
-			while (i != EOF && isspace(i)) i = input.get();
-			if (i == EOF) break;
-			input.putback(i);
-			v = Value::fromStream(input);
+			if (!readMessage(input, binary, v)) break;
 			handler.logStream = &error;
 			handler.flushMessages();
 		}
 	} catch (std::exception &e) {
-		Value({false, e.what()}).toStream(output);
-		output << std::endl;
+		//in the tagged mode, the error is not related to any request (null tag)
+		if (tagged) writeMessage({nullptr, false, e.what()}, output, binary);
+		else writeMessage({false, e.what()}, output, binary);
 	}
 	handler.logStream = nullptr;
 }
 
+///Returns true, if the request can run concurrently with other requests
+static bool isConcurrent(StrViewA cmd, const Value &args) {
+	static const std::string_view concurrent[] = {
+			"getBalance","syncTrades","getOpenOrders","getTicker","placeOrder",
+			"getFees","getInfo","getAllPairs"
+	};
+	if (cmd == "batch") {
+		for (Value r: args) if (!isConcurrent(r[0].getString(), r[1])) return false;
+		return true;
+	}
+	if (cmd == "getMarketSnapshot") return isConcurrent("batch", args["requests"]);
+	if (cmd == "subaccount") return args.hasValue() && isConcurrent(args[1].getString(), args[2]);
+	return std::find(std::begin(concurrent), std::end(concurrent), std::string_view(cmd)) != std::end(concurrent);
+}
+
+void AbstractBrokerAPI::dispatchTagged(std::istream& input, std::ostream& output, AbstractBrokerAPI &handler, bool binary) {
+	//request: [id, command, args], response: [id, ok, result]
+	//notification: ["notify", event, data]
+	std::mutex outlock;
+	//trading requests share the lock, other requests run alone
+	std::shared_mutex cfglock;
+	auto process = [&](Value req) {
+		Value resp;
+		try {
+			StrViewA cmd = req[1].getString();
+			if (isConcurrent(cmd, req[2])) {
+				std::shared_lock<std::shared_mutex> _(cfglock);
+				resp = handler.callMethod(cmd, req[2]);
+			} else {
+				std::unique_lock<std::shared_mutex> _(cfglock);
+				resp = handler.callMethod(cmd, req[2]);
+			}
+		} catch (std::exception &e) {
+			resp = {false, e.what()};
+		}
+		//error is always sent with the tag of the request
+		std::lock_guard<std::mutex> _(outlock);
+		writeMessage({req[0], resp[0], resp[1]}, output, binary);
+	};
+
+	{
+		std::lock_guard<std::mutex> _(handler.notifyLock);
+		handler.notifyOut = [&](const Value &msg) {
+			std::lock_guard<std::mutex> _(outlock);
+			writeMessage(msg, output, binary);
+		};
+	}
+	//notifications must be disabled before the output is destroyed
+	struct NotifyGuard {
+		AbstractBrokerAPI &h;
+		~NotifyGuard() {
+			std::lock_guard<std::mutex> _(h.notifyLock);
+			h.notifyOut = nullptr;
+		}
+	} notifyGuard{handler};
+
+	Value v;
+	unsigned int threads = std::max(1U, handler.getConcurrency());
+	if (threads == 1) {
+		while (readMessage(input, binary, v)) process(v);
+		return;
+	}
+
+	std::mutex qlock;
+	std::condition_variable cond;
+	std::queue<Value> queue;
+	bool finished = false;
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < threads; i++) {
+		workers.emplace_back([&]{
+			std::unique_lock<std::mutex> lk(qlock);
+			while (true) {
+				cond.wait(lk, [&]{return finished || !queue.empty();});
+				if (queue.empty()) return;
+				Value r = queue.front();
+				queue.pop();
+				lk.unlock();
+				process(r);
+				lk.lock();
+			}
+		});
+	}
+	auto finish = [&]{
+		{
+			std::lock_guard<std::mutex> _(qlock);
+			finished = true;
+		}
+		cond.notify_all();
+		for (auto &t: workers) t.join();
+	};
+	try {
+		while (readMessage(input, binary, v)) {
+			std::lock_guard<std::mutex> _(qlock);
+			queue.push(v);
+			cond.notify_one();
+		}
+	} catch (...) {
+		finish();
+		throw;
+	}
+	finish();
+}
+
+bool AbstractBrokerAPI::notify(const std::string_view &event, const std::string_view &pair) {
+	std::lock_guard<std::mutex> _(notifyLock);
+	if (!notifyOut) return false;
+	try {
+		notifyOut({"notify", StrViewA(event.data(), event.length()), StrViewA(pair.data(), pair.length())});
+		return true;
+	} catch (std::exception &) {
+		return false;
+	}
+}
+
 AbstractBrokerAPI::AbstractBrokerAPI(const std::string &secure_storage_path,
 		const Value &apiKeyFormat)
 :secure_storage_path(secure_storage_path)
@@ -8,7 +8,9 @@
 #ifndef SRC_BROKERS_API_H_
 #define SRC_BROKERS_API_H_
 
+#include <functional>
 #include <iostream>
+#include <mutex>
 
 #include <imtjson/value.h>
 #include "../main/apikeys.h"
@@ -106,6 +108,42 @@ public:
 
 	virtual json::Value callMethod(std::string_view name, json::Value args);
 
+	///Returns count of requests which can be processed at once
+	/**
+	 * Used when the tagged protocol is active. Default value is 1, so requests are
+	 * processed one by one (the client still doesn't need to wait for the response
+	 * before it sends next request). MT safe broker can return higher number.
+	 *
+	 * Only trading requests (getBalance, syncTrades, getOpenOrders, getTicker, placeOrder,
+	 * getFees, getInfo, getAllPairs and batches of them) run concurrently. Other
+	 * requests (setApiKey, setSettings, reset, ...) wait until running requests finish,
+	 * and they run alone.
+	 */
+	virtual unsigned int getConcurrency() const {return 1;}
+
+	///Called before requests of the market snapshot are processed
+	/**
+	 * Market snapshot is requested at the beginning of the cycle for all pairs of all traders
+	 * which use this broker. The broker can fetch data of all pairs by bulk requests
+	 * and keep them in the cache until reset().
+	 *
+	 * @param pairs list of pairs (can contain duplicates)
+	 */
+	virtual void prepareSnapshot(const std::vector<std::string> &pairs) {}
+
+	///Sends asynchronous notification to the mmbot
+	/**
+	 * Available only when the tagged protocol is active. The function can be called
+	 * from any thread (for example from the thread of the stream). The mmbot can wake up
+	 * traders of the pair immediately instead of waiting to the next cycle.
+	 *
+	 * @param event "fill" - order has been executed (even partially), "price" - price has been changed
+	 * @param pair affected pair
+	 * @retval true sent
+	 * @retval false notifications are not available
+	 */
+	bool notify(const std::string_view &event, const std::string_view &pair);
+
 protected:
 	bool debug_mode = false;
 	std::string secure_storage_path;
@@ -117,6 +155,12 @@ protected:
 	class LogProvider;
 	ondra_shared::RefCntPtr<LogProvider> logProvider;
 
+	///writes notification to the output, defined while tagged protocol is active
+	std::function<void(const json::Value &)> notifyOut;
+	std::mutex notifyLock;
+
+	static void dispatchTagged(std::istream &input, std::ostream &output, AbstractBrokerAPI &handler, bool binary);
+
 	friend json::Value handleSubaccount(AbstractBrokerAPI &handler, const json::Value &req);
 
 };
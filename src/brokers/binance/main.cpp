@@ -4,11 +4,17 @@
  *  Created on: 21. 5. 2019
  *      Author: ondra
  */
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
 #include <rpc/rpcServer.h>
+#include <imtjson/array.h>
+#include <imtjson/object.h>
 #include <imtjson/operations.h>
 #include "shared/toString.h"
 #include "proxy.h"
@@ -16,6 +22,8 @@
 #include <ctime>
 
 #include "../api.h"
+#include "../market_stream.h"
+#include "stream.h"
 #include <imtjson/stringValue.h>
 #include <shared/linear_map.h>
 #include <shared/iterator_stream.h>
@@ -55,6 +63,7 @@ public:
 	virtual double getBalance(const std::string_view & symb, const std::string_view & pair) override;
 	virtual double getBalance(const std::string_view & symb) override {return 0;}
 	virtual TradesSync syncTrades(json::Value lastId, const std::string_view & pair) override;
+	TradesSync restSyncTrades(json::Value lastId, const std::string_view & pair);
 	virtual Orders getOpenOrders(const std::string_view & par)override;
 	virtual Ticker getTicker(const std::string_view & piar)override;
 	virtual json::Value placeOrder(const std::string_view & pair,
@@ -74,6 +83,9 @@ public:
 		return new Interface(path);
 	}
 	virtual json::Value getMarkets() const override;
+	virtual void prepareSnapshot(const std::vector<std::string> &pairs) override;
+	///Requests are independent HTTP requests (each uses own connection from the pool)
+	virtual unsigned int getConcurrency() const override {return 4;}
 
 	enum class Category {
 		spot, coin_m, usdt_m
@@ -87,13 +99,19 @@ public:
 
 	using Symbols = ondra_shared::linear_map<std::string, MarketInfoEx, std::less<std::string_view> > ;
 	using Tickers = ondra_shared::linear_map<std::string, Ticker,  std::less<std::string_view> >;
+	using PSymbols = std::shared_ptr<const Symbols>;
+
+	///protects caches, requests can be processed concurrently. Never held during a request
+	std::mutex cacheLock;
 
 	Value balanceCache;
 	Tickers tickerCache;
+	///open orders of all spot symbols (indexed by symbol), fetched by the market snapshot
 	Value orderCache;
 	Value feeInfo;
 	std::chrono::system_clock::time_point feeInfoExpiration;
-	Symbols symbols;
+	///symbols are replaced as whole, so readers can keep the snapshot
+	PSymbols symbols;
 	using TradeMap = ondra_shared::linear_map<std::string, std::vector<Trade> > ;
 
 
@@ -103,12 +121,12 @@ public:
 
 
 	static bool tradeOrder(const Trade &a, const Trade &b);
-	void updateBalCache();
+	Value updateBalCache();
 	Value generateOrderId(Value clientId);
 
-	std::uintptr_t idsrc;
+	std::atomic<std::uintptr_t> idsrc;
 
-	void initSymbols();
+	PSymbols initSymbols();
 
 	Value dapi_readAccount();
 	std::chrono::steady_clock::time_point symbolsExpire;
@@ -118,6 +136,16 @@ public:
 	virtual json::Value getSettings(const std::string_view &pairHint) const;
 
 	bool feesInBnb = false;
+	///use websocket stream for tickers, orders and trades (spot)
+	bool useStream = false;
+	///url of the stream (empty - default). Allows to connect to a local replay server
+	std::string streamUrl;
+
+	StreamState streamState;
+	std::unique_ptr<BinanceStream> streamProto;
+	std::unique_ptr<MarketStream> stream;
+
+	void initStream();
 
 protected:
 	bool dapi_isSymbol(const std::string_view &pair);
@@ -134,30 +162,34 @@ private:
 };
 
 
-void Interface::updateBalCache() {
-	 if (!balanceCache.defined()) {
-		 balanceCache = px.private_request(Proxy::GET,"/api/v3/account",json::object);
-		 feeInfo = balanceCache["makerCommission"].getNumber()/10000.0;
-		 Object r;
-		 for (Value x : balanceCache["balances"]) {
-			 r.set(x["asset"].getString(), x);
-		 }
-		 balanceCache = balanceCache.replace("balances", r);
-	 }
+Value Interface::updateBalCache() {
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		if (balanceCache.defined()) return balanceCache;
+	}
+	Value account = px.private_request(Proxy::GET,"/api/v3/account",json::object);
+	Object r;
+	for (Value x : account["balances"]) {
+		r.set(x["asset"].getString(), x);
+	}
+	account = account.replace("balances", r);
+	std::lock_guard<std::mutex> _(cacheLock);
+	balanceCache = account;
+	feeInfo = account["makerCommission"].getNumber()/10000.0;
+	return account;
 }
 
 
  double Interface::getBalance(const std::string_view & symb, const std::string_view & pair) {
 	 if (dapi_isSymbol(pair)) {
-		initSymbols();
-		auto iter = symbols.find(pair);
-		if (iter == symbols.end()) throw std::runtime_error("No such symbol");
+		auto smb = initSymbols();
+		auto iter = smb->find(pair);
+		if (iter == smb->end()) throw std::runtime_error("No such symbol");
 		const MarketInfo &minfo = iter->second;
 		if (minfo.asset_symbol == symb) return dapi_getPosition(pair.substr(COIN_M_FUTURES_PREFIX.length()))*minfo.asset_step;
 		else return dapi_getCollateral(symb);
 	 } else {
-		 updateBalCache();
-		 Value v =balanceCache["balances"][symb];
+		 Value v = updateBalCache()["balances"][symb];
 		 if (v.defined()) return v["free"].getNumber()+v["locked"].getNumber();
 		 else throw std::runtime_error("No such symbol");
 	 }
@@ -182,10 +214,24 @@ void Interface::updateBalCache() {
 
  }
 */
- Interface::TradesSync Interface::syncTrades(json::Value lastId, const std::string_view & pair) {
-	 initSymbols();
-	 auto iter = symbols.find(pair);
-	 if (iter == symbols.end())
+Interface::TradesSync Interface::syncTrades(json::Value lastId, const std::string_view & pair) {
+	if (!stream || dapi_isSymbol(pair)) return restSyncTrades(lastId, pair);
+	auto res = streamState.syncTrades(lastId, pair);
+	if (res.has_value()) return *res;
+	auto smb = initSymbols();
+	auto iter = smb->find(pair);
+	if (iter != smb->end()) streamProto->watch(pair, iter->second.asset_symbol, iter->second.currency_symbol);
+	//fills received since now are returned by the stream
+	auto epoch = streamState.getEpoch();
+	TradesSync rest = restSyncTrades(lastId, pair);
+	streamState.anchorTrades(pair, rest.lastId, epoch);
+	return rest;
+}
+
+ Interface::TradesSync Interface::restSyncTrades(json::Value lastId, const std::string_view & pair) {
+	 auto smb = initSymbols();
+	 auto iter = smb->find(pair);
+	 if (iter == smb->end())
 		 throw std::runtime_error("No such symbol");
 
 	 const MarketInfo &minfo = iter->second;
@@ -265,27 +311,10 @@ void Interface::updateBalCache() {
 
 			 TradeHistory h(mapJSON(r,[&](Value x){
 				 double size = x["qty"].getNumber();
-				 double price = x["price"].getNumber();
-				 StrViewA comass = x["commissionAsset"].getString();
 				 if (!x["isBuyer"].getBool()) size = -size;
-				 double comms = x["commission"].getNumber();
-				 double eff_size = size;
-				 double eff_price = price;
-				 if (comass == StrViewA(minfo.asset_symbol)) {
-					 eff_size -= comms;
-					 eff_price =  std::abs(size * price / eff_size);
-				 } else if (comass == StrViewA(minfo.currency_symbol)) {
-					 eff_price += comms/size;
-				 }
-
-				 return Trade {
-					 x["id"],
-					 x["time"].getUIntLong(),
-					 size,
-					 price,
-					 eff_size,
-					 eff_price
-				 };
+				 return spotTrade(x["id"], x["time"].getUIntLong(), size, x["price"].getNumber(),
+						 x["commission"].getNumber(), x["commissionAsset"].getString(),
+						 minfo.asset_symbol, minfo.currency_symbol);
 			 }, TradeHistory()));
 
 			 std::sort(h.begin(), h.end(),[&](const Trade &a, const Trade &b) {
@@ -312,31 +341,28 @@ void Interface::updateBalCache() {
 }
 
 
-static Value extractOrderID(StrViewA id) {
-	if (id.begins("mmbot")) {
-		Value bin = base64url->decodeBinaryValue(id.substr(5));
-		try {
-			auto stream = json::fromBinary(bin.getBinary(base64url));
-			return Value::parseBinary([&]{
-					int c = stream();
-					if (c == -1) throw 0;
-					return c;
-			},json::base64url)[1];
-		} catch (...) {
-			return Value();
-		}
-	} else {
-		return Value();
+///Converts open orders of spot symbol
+static IStockApi::Orders spotOrders(Value resp) {
+	IStockApi::Orders res;
+	for (Value x: resp) {
+		Value id = x["clientOrderId"];
+		Value eoid = extractOrderID(id.getString());
+		res.push_back(IStockApi::Order {
+			x["orderId"],
+			eoid,
+			(x["side"].getString() == "SELL"?-1:1)*(x["origQty"].getNumber() - x["executedQty"].getNumber()),
+			x["price"].getNumber()
+		});
 	}
-
+	return res;
 }
 
 Interface::Orders Interface::getOpenOrders(const std::string_view & pair) {
 	if (dapi_isSymbol(pair)) {
-		initSymbols();
+		auto smb = initSymbols();
 		auto cpair = pair.substr(COIN_M_FUTURES_PREFIX.length());
-		auto iter = symbols.find(pair);
-		if (iter == symbols.end()) throw std::runtime_error("Unknown symbol");
+		auto iter = smb->find(pair);
+		if (iter == smb->end()) throw std::runtime_error("Unknown symbol");
 		const MarketInfo &minfo = iter->second;
 		Value resp = dapi.private_request(Proxy::GET,"/dapi/v1/openOrders", Object("symbol",cpair));
 		return mapJSON(resp, [&](Value x) {
@@ -350,17 +376,25 @@ Interface::Orders Interface::getOpenOrders(const std::string_view & pair) {
 			};
 		}, Orders());
 	} else {
-		Value resp = px.private_request(Proxy::GET,"/api/v3/openOrders", Object("symbol",pair));
-		return mapJSON(resp, [&](Value x) {
-			Value id = x["clientOrderId"];
-			Value eoid = extractOrderID(id.getString());
-			return Order {
-				x["orderId"],
-				eoid,
-				(x["side"].getString() == "SELL"?-1:1)*(x["origQty"].getNumber() - x["executedQty"].getNumber()),
-				x["price"].getNumber()
-			};
-		}, Orders());
+		if (stream) {
+			auto orders = streamState.getOrders(pair);
+			if (orders.has_value()) return *orders;
+		}
+		auto version = streamState.getOrdersVersion(pair);
+		Value cache;
+		{
+			std::lock_guard<std::mutex> _(cacheLock);
+			cache = orderCache;
+		}
+		bool cached = cache.defined();
+		//cache contains all open orders, so missing symbol has no orders
+		Value resp = cached?cache[pair]
+				:px.private_request(Proxy::GET,"/api/v3/openOrders", Object("symbol",pair));
+		Orders res = spotOrders(resp);
+		//orders are maintained by the stream since now (cached orders are already set
+		//by the prepareSnapshot)
+		if (stream && !cached) streamState.setOrders(pair, res, version);
+		return res;
 	}
 }
 
@@ -379,7 +413,9 @@ static Value indexBySymbol(Value data) {
 Interface::Ticker Interface::getTicker(const std::string_view &pair) {
 	if (dapi_isSymbol(pair)) {
 		auto cpair = pair.substr(COIN_M_FUTURES_PREFIX.length());
+		std::unique_lock<std::mutex> lk(cacheLock);
 		if (dapi_tickers.empty()) {
+			lk.unlock();
 			std::vector<Tickers::value_type> tk;
 			Value book = dapi.public_request("/dapi/v1/ticker/bookTicker",Value());
 			for (Value v: book) {
@@ -391,6 +427,7 @@ Interface::Ticker Interface::getTicker(const std::string_view &pair) {
 					Ticker{bid,ask,midl,v["time"].getUIntLong()}
 				);
 			}
+			lk.lock();
 			dapi_tickers = Tickers(std::move(tk));
 		}
 
@@ -398,8 +435,14 @@ Interface::Ticker Interface::getTicker(const std::string_view &pair) {
 		 if (iter != dapi_tickers.end()) return iter->second;
 		 else throw std::runtime_error("No such symbol");
 	} else {
+		if (stream) {
+			auto tk = streamState.getTicker(pair);
+			if (tk.has_value()) return *tk;
+			stream->subscribe(pair);
+		}
+		std::unique_lock<std::mutex> lk(cacheLock);
 		if (tickerCache.empty()) {
-
+			 lk.unlock();
 			 Value book = indexBySymbol(px.public_request("/api/v3/ticker/bookTicker", Value()));
 			 Value price = indexBySymbol(px.public_request("/api/v3/ticker/price", Value()));
 			 auto bs = ondra_shared::iterator_stream(book);
@@ -423,6 +466,7 @@ Interface::Ticker Interface::getTicker(const std::string_view &pair) {
 					 ps();
 				 }
 			 }
+			 lk.lock();
 			 tickerCache = Tickers(std::move(tk));
 		 }
 
@@ -433,9 +477,9 @@ Interface::Ticker Interface::getTicker(const std::string_view &pair) {
 }
 
 std::vector<std::string> Interface::getAllPairs() {
-	initSymbols();
+	auto smb = initSymbols();
  	 std::vector<std::string> res;
-	 for (auto &&v: symbols) res.push_back(v.first);
+	 for (auto &&v: *smb) res.push_back(v.first);
 	 return res;
  }
 
@@ -459,10 +503,15 @@ json::Value Interface::placeOrder(const std::string_view & pair,
 		json::Value replaceId,
 		double replaceSize) {
 
+	//open orders are changing, cache is no longer valid
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		orderCache = Value();
+	}
 	if (dapi_isSymbol(pair)) {
-		initSymbols();
-		auto iter = symbols.find(pair);
-		if (iter == symbols.end()) throw std::runtime_error("Unknown symbol");
+		auto smb = initSymbols();
+		auto iter = smb->find(pair);
+		if (iter == smb->end()) throw std::runtime_error("Unknown symbol");
 		auto cpair = pair.substr(COIN_M_FUTURES_PREFIX.length());
 		size = -size/iter->second.asset_step;
 		replaceSize = replaceSize/iter->second.asset_step;
@@ -521,7 +570,60 @@ json::Value Interface::placeOrder(const std::string_view & pair,
 	}
 }
 
+void Interface::prepareSnapshot(const std::vector<std::string> &pairs) {
+	//one request for all open orders is cheaper than one request per symbol
+	//symbols which have orders maintained by the stream don't need the request
+	std::unordered_map<std::string, std::uint64_t> versions;
+	for (const std::string &p: pairs) {
+		if (dapi_isSymbol(p)) continue;
+		if (stream && streamState.getOrders(p).has_value()) continue;
+		//version must be captured before the request
+		versions.emplace(p, streamState.getOrdersVersion(p));
+	}
+	if (versions.size() < 2) return;
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		if (orderCache.defined()) return;
+	}
+	Value resp = px.private_request(Proxy::GET,"/api/v3/openOrders", json::object);
+	std::unordered_map<std::string, Array> bysymb;
+	for (Value x: resp) {
+		StrViewA symb = x["symbol"].getString();
+		bysymb[std::string(symb.data, symb.length)].push_back(x);
+	}
+	Object bld;
+	for (auto &&x: bysymb) bld.set(x.first, x.second);
+	Value cache = bld;
+	//orders are maintained by the stream since now
+	if (stream) {
+		for (auto &&v: versions) {
+			streamState.setOrders(v.first, spotOrders(cache[v.first]), v.second);
+		}
+	}
+	std::lock_guard<std::mutex> _(cacheLock);
+	orderCache = cache;
+}
+
+void Interface::initStream() {
+	if (useStream && px.hasKey()) {
+		if (stream) return;
+		streamProto = std::make_unique<BinanceStream>(px, streamUrl.empty()?std::string(binanceStreamUrl):streamUrl);
+		streamProto->onFill = [this](const std::string_view &symbol) {
+			notify("fill", symbol);
+		};
+		stream = std::make_unique<MarketStream>(simpleServer::HttpClient("+https://mmbot.trade",
+				simpleServer::newHttpsProvider(),
+				simpleServer::newNoProxyProvider()), *streamProto, streamState);
+		stream->start();
+	} else {
+		stream.reset();
+		streamProto.reset();
+	}
+}
+
 bool Interface::reset() {
+	if (streamProto) streamProto->keepAlive();
+	std::lock_guard<std::mutex> _(cacheLock);
 	balanceCache = Value();
 	tickerCache.clear();
 	orderCache = Value();
@@ -532,83 +634,88 @@ bool Interface::reset() {
 	return true;
 }
 
-void Interface::initSymbols() {
+Interface::PSymbols Interface::initSymbols() {
 	auto now = std::chrono::steady_clock::now();
-	if (symbols.empty() || symbolsExpire < now) {
-		Value res = px.public_request("/api/v1/exchangeInfo",Value());
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		if (symbols != nullptr && !symbols->empty() && symbolsExpire >= now) return symbols;
+	}
+	Value res = px.public_request("/api/v1/exchangeInfo",Value());
+
+
+	using VT = Symbols::value_type;
+	std::vector<VT> bld;
+	for (Value smb: res["symbols"]) {
+		std::string symbol = smb["symbol"].getString();
+		MarketInfoEx nfo;
+		nfo.asset_symbol = smb["baseAsset"].getString();
+		nfo.currency_symbol = smb["quoteAsset"].getString();
+		nfo.currency_step = std::pow(10,-smb["quotePrecision"].getNumber());
+		nfo.asset_step = std::pow(10,-smb["baseAssetPrecision"].getNumber());
+		nfo.feeScheme = income;
+		nfo.min_size = 0;
+		nfo.min_volume = 0;
+		nfo.fees = getFees(symbol);
+		for (Value f: smb["filters"]) {
+			auto ft = f["filterType"].getString();
+			if (ft == "LOT_SIZE") {
+				nfo.min_size = f["minQty"].getNumber();
+				nfo.asset_step = f["stepSize"].getNumber();
+			} else if (ft == "PRICE_FILTER") {
+				nfo.currency_step = f["tickSize"].getNumber();
+			} else if (ft == "MIN_NOTIONAL") {
+				nfo.min_volume = f["minNotional"].getNumber();
+			}
+		}
+		nfo.cat = Category::spot;
+		nfo.wallet_id="spot";
 
+		if (feesInBnb) {
+			if (nfo.asset_symbol == "BNB") nfo.feeScheme = assets;
+			else nfo.feeScheme = currency;
+		}
 
-		using VT = Symbols::value_type;
-		std::vector<VT> bld;
+		bld.push_back(VT(symbol, nfo));
+	}
+	try {
+		res = dapi.public_request("/dapi/v1/exchangeInfo",Value());
 		for (Value smb: res["symbols"]) {
-			std::string symbol = smb["symbol"].getString();
+			std::string symbol = COIN_M_FUTURES_PREFIX + std::string(smb["symbol"].getString());
 			MarketInfoEx nfo;
-			nfo.asset_symbol = smb["baseAsset"].getString();
-			nfo.currency_symbol = smb["quoteAsset"].getString();
-			nfo.currency_step = std::pow(10,-smb["quotePrecision"].getNumber());
-			nfo.asset_step = std::pow(10,-smb["baseAssetPrecision"].getNumber());
-			nfo.feeScheme = income;
-			nfo.min_size = 0;
-			nfo.min_volume = 0;
+			nfo.asset_symbol = smb["quoteAsset"].getString();
+			nfo.currency_symbol = smb["marginAsset"].getString();
+			nfo.currency_step = std::pow(10,-smb["pricePrecision"].getNumber());
+			nfo.asset_step = smb["contractSize"].getNumber();
+			nfo.feeScheme = currency;
 			nfo.fees = getFees(symbol);
+			nfo.min_size = nfo.asset_step;
+			nfo.min_volume = 0;
 			for (Value f: smb["filters"]) {
 				auto ft = f["filterType"].getString();
 				if (ft == "LOT_SIZE") {
-					nfo.min_size = f["minQty"].getNumber();
-					nfo.asset_step = f["stepSize"].getNumber();
+					nfo.min_size = f["minQty"].getNumber()*nfo.asset_step;
 				} else if (ft == "PRICE_FILTER") {
 					nfo.currency_step = f["tickSize"].getNumber();
-				} else if (ft == "MIN_NOTIONAL") {
-					nfo.min_volume = f["minNotional"].getNumber();
 				}
 			}
-			nfo.cat = Category::spot;
-			nfo.wallet_id="spot";
-
-			if (feesInBnb) {
-				if (nfo.asset_symbol == "BNB") nfo.feeScheme = assets;
-				else nfo.feeScheme = currency;
-			}
-
+			nfo.leverage = dapi_getLeverage(smb["symbol"].getString());
+			nfo.invert_price = true;
+			nfo.inverted_symbol = smb["quoteAsset"].getString();
+			nfo.cat = Category::coin_m;
+			nfo.label = nfo.currency_symbol+"/"+nfo.asset_symbol;
+			nfo.type = smb["contractType"].getString();
+			nfo.wallet_id = symbol;
 			bld.push_back(VT(symbol, nfo));
 		}
-		try {
-			res = dapi.public_request("/dapi/v1/exchangeInfo",Value());
-			for (Value smb: res["symbols"]) {
-				std::string symbol = COIN_M_FUTURES_PREFIX + std::string(smb["symbol"].getString());
-				MarketInfoEx nfo;
-				nfo.asset_symbol = smb["quoteAsset"].getString();
-				nfo.currency_symbol = smb["marginAsset"].getString();
-				nfo.currency_step = std::pow(10,-smb["pricePrecision"].getNumber());
-				nfo.asset_step = smb["contractSize"].getNumber();
-				nfo.feeScheme = currency;
-				nfo.fees = getFees(symbol);
-				nfo.min_size = nfo.asset_step;
-				nfo.min_volume = 0;
-				for (Value f: smb["filters"]) {
-					auto ft = f["filterType"].getString();
-					if (ft == "LOT_SIZE") {
-						nfo.min_size = f["minQty"].getNumber()*nfo.asset_step;
-					} else if (ft == "PRICE_FILTER") {
-						nfo.currency_step = f["tickSize"].getNumber();
-					}
-				}
-				nfo.leverage = dapi_getLeverage(smb["symbol"].getString());
-				nfo.invert_price = true;
-				nfo.inverted_symbol = smb["quoteAsset"].getString();
-				nfo.cat = Category::coin_m;
-				nfo.label = nfo.currency_symbol+"/"+nfo.asset_symbol;
-				nfo.type = smb["contractType"].getString();
-				nfo.wallet_id = symbol;
-				bld.push_back(VT(symbol, nfo));
-			}
-		} catch (std::exception &e) {
-			logError("DAPI is not available: $1", e.what());
-		}
-
-		symbols = Symbols(std::move(bld));
-		symbolsExpire = now + std::chrono::minutes(15);
+	} catch (std::exception &e) {
+		logError("DAPI is not available: $1", e.what());
 	}
+
+	PSymbols nsymb = std::make_shared<const Symbols>(std::move(bld));
+	std::lock_guard<std::mutex> _(cacheLock);
+	symbols = nsymb;
+	symbolsExpire = now + std::chrono::minutes(15);
+	return nsymb;
 }
 
 void Interface::onInit() {
@@ -616,10 +723,10 @@ void Interface::onInit() {
 }
 
 inline Interface::MarketInfo Interface::getMarketInfo(const std::string_view &pair) {
-	initSymbols();
+	auto smb = initSymbols();
 
-	auto iter = symbols.find(pair);
-	if (iter == symbols.end())
+	auto iter = smb->find(pair);
+	if (iter == smb->end())
 		throw std::runtime_error("Unknown trading pair symbol");
 	MarketInfo res = iter->second;
 	if (dapi_isSymbol(pair)) {
@@ -637,10 +744,11 @@ inline double Interface::getFees(const std::string_view &pair) {
 		if (dapi_isSymbol(pair)) {
 			return dapi_getFees();
 		} else {
-			 if (!feeInfo.defined()) {
-				 updateBalCache();
+			 {
+				 std::lock_guard<std::mutex> _(cacheLock);
+				 if (feeInfo.defined()) return feeInfo.getNumber();
 			 }
-			 return feeInfo.getNumber();
+			 return updateBalCache()["makerCommission"].getNumber()/10000.0;
 		}
 	} else {
 		if (dapi_isSymbol(pair)) {
@@ -665,7 +773,13 @@ inline void Interface::onLoadApiKey(json::Value keyData) {
 	px.pubKey = keyData["pubKey"].getString();
 	dapi.privKey = px.privKey;
 	dapi.pubKey = px.pubKey;
-	symbols.clear();
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		symbols = nullptr;
+	}
+	//restart the stream with new keys
+	stream.reset();
+	initStream();
 }
 
 inline Value Interface::generateOrderId(Value clientId) {
@@ -745,11 +859,14 @@ int main(int argc, char **argv) {
 }
 
 inline Value Interface::dapi_readAccount() {
-	if (!dapi_account.defined()) {
-		Value account = dapi.private_request(Proxy::GET, "/dapi/v1/account", Value());
-		dapi_account = account;
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		if (dapi_account.defined()) return dapi_account;
 	}
-	return dapi_account;
+	Value account = dapi.private_request(Proxy::GET, "/dapi/v1/account", Value());
+	std::lock_guard<std::mutex> _(cacheLock);
+	dapi_account = account;
+	return account;
 }
 
 inline double Interface::dapi_getFees() {
@@ -770,10 +887,17 @@ inline double Interface::dapi_getLeverage(const json::StrViewA &pair) {
 }
 
 inline double Interface::dapi_getPosition(const json::StrViewA &pair) {
-	if (!dapi_positions.defined()) {
-		dapi_positions = dapi.private_request(Proxy::GET, "/dapi/v1/positionRisk", Value());
+	Value positions;
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		positions = dapi_positions;
 	}
-	Value z = dapi_positions.find([&](Value item){return item["symbol"].getString() == pair;});
+	if (!positions.defined()) {
+		positions = dapi.private_request(Proxy::GET, "/dapi/v1/positionRisk", Value());
+		std::lock_guard<std::mutex> _(cacheLock);
+		dapi_positions = positions;
+	}
+	Value z = positions.find([&](Value item){return item["symbol"].getString() == pair;});
 	return -z["positionAmt"].getNumber();
 }
 
@@ -785,7 +909,7 @@ inline double Interface::dapi_getCollateral(const json::StrViewA &pair) {
 }
 
 inline json::Value Interface::getMarkets() const {
-	const_cast<Interface *>(this)->initSymbols();
+	auto smb = const_cast<Interface *>(this)->initSymbols();
 	using Map = std::map<std::pair<std::string_view, std::string_view>, std::string_view>;
 	auto loadToMap = [](const auto &map) {
 		Object lst;
@@ -809,14 +933,14 @@ inline json::Value Interface::getMarkets() const {
 	Object res;
 	{
 		Map map;
-		for (auto &&v: symbols) if (v.second.cat == Category::spot) {
+		for (auto &&v: *smb) if (v.second.cat == Category::spot) {
 			map.emplace(std::pair(std::string_view(v.second.asset_symbol), std::string_view(v.second.currency_symbol)), v.first);
 		}
 		res.set("Spot",loadToMap(map));
 	}
 	{
 		Map map;
-		for (auto &&v: symbols) if (v.second.cat == Category::coin_m) {
+		for (auto &&v: *smb) if (v.second.cat == Category::coin_m) {
 			map.emplace(std::pair(std::string_view(v.second.label), std::string_view(v.second.type)), v.first);
 		}
 		res.set("COIN-Ⓜ Futures",loadToMap(map));
@@ -829,7 +953,18 @@ inline json::Value Interface::getMarkets() const {
 
 inline json::Value Interface::setSettings(json::Value v) {
 	feesInBnb = v["bnbfee"].getBool();
-	symbols.clear();
+	useStream = v["stream"].getString() == "yes";
+	std::string url = v["stream_url"].getString();
+	if (url != streamUrl) {
+		//reconnect to the new url
+		streamUrl = url;
+		stream.reset();
+	}
+	{
+		std::lock_guard<std::mutex> _(cacheLock);
+		symbols = nullptr;
+	}
+	initStream();
 	return v;
 }
 
@@ -842,7 +977,20 @@ inline json::Value Interface::getSettings(const std::string_view &) const {
 			("options",Object
 					("yes","Enabled")
 					("no","Disabled"))
-			("default",feesInBnb?"yes":"no")
+			("default",feesInBnb?"yes":"no"),
+		Object
+			("name","stream")
+			("label","Use websocket stream (spot)")
+			("type","enum")
+			("options",Object
+					("yes","Enabled")
+					("no","Disabled"))
+			("default",useStream?"yes":"no"),
+		Object
+			("name","stream_url")
+			("label","Stream url (empty = default)")
+			("type","string")
+			("default",streamUrl)
 	};
 }
 
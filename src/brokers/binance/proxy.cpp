@@ -45,9 +45,11 @@ std::uint64_t Proxy::now() {
 }
 
 void Proxy::setTime(std::uint64_t t ) {
-	this->time_diff = 0;
-	auto n = now();
-	this->time_diff = t - n;
+	//other threads can read the time meanwhile, so the difference is set at once
+	std::int64_t n = std::chrono::duration_cast<std::chrono::milliseconds>(
+						 std::chrono::steady_clock::now().time_since_epoch()
+						 ).count();
+	this->time_diff = static_cast<std::int64_t>(t) - n;
 }
 
 void Proxy::buildParams(const json::Value& params, std::ostream& data) {
@@ -88,15 +90,18 @@ json::Value Proxy::private_request(Method method, std::string command, json::Val
 	if (!hasKey())
 		throw std::runtime_error("Function requires valid API keys");
 
-	auto n = now();
-	if (n > time_sync) {
-		json::Value tdata = public_request(timeUri,json::Value());
-		auto m = tdata["serverTime"].getUIntLong();
-		setTime(m);
+	std::uint64_t n;
+	{
+		std::lock_guard<std::mutex> _(timeLock);
 		n = now();
-		time_sync = n + (3600*1000); //- one hour
-		logDebug("Time sync: $1. Next sync at: $2", n, time_sync);
-
+		if (n > time_sync) {
+			json::Value tdata = public_request(timeUri,json::Value());
+			auto m = tdata["serverTime"].getUIntLong();
+			setTime(m);
+			n = now();
+			time_sync = n + (3600*1000); //- one hour
+			logDebug("Time sync: $1. Next sync at: $2", n, time_sync);
+		}
 	}
 	data = data.replace("timestamp", n);
 
@@ -152,6 +157,28 @@ json::Value Proxy::private_request(Method method, std::string command, json::Val
 	return res;
 }
 
+json::Value Proxy::apikey_request(Method method, std::string command, json::Value data) {
+	if (!hasKey())
+		throw std::runtime_error("Function requires valid API keys");
+
+	std::ostringstream databld;
+	buildParams(data, databld);
+	std::string request = databld.str();
+	if (!request.empty()) request = request.substr(1);
+
+	json::Object headers;
+	headers("X-MBX-APIKEY",pubKey);
+	if (method == GET) {
+		return httpc.GET(request.empty()?command:command + "?" + request, headers);
+	} else if (method == DELETE) {
+		return httpc.DELETE(request.empty()?command:command + "?" + request, json::String(), headers);
+	} else {
+		headers("Content-Type","application/x-www-form-urlencoded");
+		if (method == POST) return httpc.POST(command, request, headers);
+		else return httpc.PUT(command, request, headers);
+	}
+}
+
 bool Proxy::hasKey() const {
 	return !privKey.empty() && !pubKey.empty();
 }
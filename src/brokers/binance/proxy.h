@@ -8,7 +8,9 @@
 #ifndef SRC_COINMATE_PROXY_H_
 #define SRC_COINMATE_PROXY_H_
 
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <imtjson/value.h>
 #include <imtjson/string.h>
 #include "../httpjson.h"
@@ -33,6 +35,8 @@ public:
 
 	json::Value public_request(std::string method, json::Value data);
 	json::Value private_request(Method method, std::string command, json::Value data);
+	///Request which requires API key but not the signature (USER_STREAM)
+	json::Value apikey_request(Method method, std::string command, json::Value data);
 
 	bool hasKey() const;
 	void setTime(std::uint64_t t);
@@ -44,8 +48,10 @@ public:
 
 
 private:
-	std::int64_t time_diff = 0;
+	std::atomic<std::int64_t> time_diff = 0;
 	std::uint64_t time_sync = 0;
+	///protects time synchronization (requests can be processed concurrently)
+	std::mutex timeLock;
 	void buildParams(const json::Value& params, std::ostream& data);
 };
 
@@ -0,0 +1,134 @@
+/*
+ * stream.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "stream.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iterator>
+#include <imtjson/binary.h>
+#include <imtjson/binjson.tcc>
+#include <imtjson/object.h>
+#include <imtjson/streams.h>
+#include "../../shared/logOutput.h"
+
+using ondra_shared::logError;
+
+using namespace json;
+
+IStockApi::Trade spotTrade(Value id, std::uint64_t time, double size, double price,
+		double comms, StrViewA comass, StrViewA asset, StrViewA currency) {
+	 double eff_size = size;
+	 double eff_price = price;
+	 if (comass == asset) {
+		 eff_size -= comms;
+		 eff_price =  std::abs(size * price / eff_size);
+	 } else if (comass == currency) {
+		 eff_price += comms/size;
+	 }
+	 return IStockApi::Trade {id, time, size, price, eff_size, eff_price};
+}
+
+Value extractOrderID(StrViewA id) {
+	if (id.begins("mmbot")) {
+		Value bin = base64url->decodeBinaryValue(id.substr(5));
+		try {
+			auto stream = json::fromBinary(bin.getBinary(base64url));
+			return Value::parseBinary([&]{
+					int c = stream();
+					if (c == -1) throw 0;
+					return c;
+			},json::base64url)[1];
+		} catch (...) {
+			return Value();
+		}
+	} else {
+		return Value();
+	}
+
+}
+
+std::string BinanceStream::getUrl() {
+	Value r = px.apikey_request(Proxy::POST, "/api/v3/userDataStream", Value());
+	std::lock_guard<std::mutex> _(lock);
+	listenKey = r["listenKey"].toString().c_str();
+	keepAliveTime = std::chrono::steady_clock::now() + std::chrono::minutes(30);
+	return wsUrl + "/stream?streams=" + listenKey;
+}
+
+void BinanceStream::subscribe(MarketStream &stream, const std::string &symbol) {
+	std::string s;
+	std::transform(symbol.begin(), symbol.end(), std::back_inserter(s), tolower);
+	s.append("@ticker");
+	std::lock_guard<std::mutex> _(lock);
+	stream.send(Object("method","SUBSCRIBE")("params",Value(json::array,{StrViewA(s)}))("id",reqId++));
+}
+
+void BinanceStream::watch(const std::string_view &pair, const std::string &asset, const std::string &currency) {
+	std::lock_guard<std::mutex> _(lock);
+	assets[std::string(pair)] = {asset, currency};
+}
+
+void BinanceStream::keepAlive() {
+	std::unique_lock<std::mutex> lk(lock);
+	if (listenKey.empty() || std::chrono::steady_clock::now() < keepAliveTime) return;
+	std::string key = listenKey;
+	keepAliveTime = std::chrono::steady_clock::now() + std::chrono::minutes(30);
+	lk.unlock();
+	try {
+		px.apikey_request(Proxy::PUT, "/api/v3/userDataStream", Object("listenKey", key));
+	} catch (std::exception &e) {
+		//expired key is reported by the stream, which reconnects with new key
+		logError("Failed to extend listen key: $1", e.what());
+	}
+}
+
+bool BinanceStream::onMessage(const json::Value &msg, StreamState &state) {
+	Value data = msg["data"];
+	//responses to SUBSCRIBE don't have data
+	if (!data.defined()) return true;
+	StrViewA e = data["e"].getString();
+	if (e == "24hrTicker") {
+		state.updateTicker(data["s"].getString(), StreamState::Ticker{
+			data["b"].getNumber(),
+			data["a"].getNumber(),
+			data["c"].getNumber(),
+			data["E"].getUIntLong()
+		});
+	} else if (e == "executionReport") {
+		StrViewA symb = data["s"].getString();
+		StrViewA status = data["X"].getString();
+		double side = data["S"].getString() == "SELL"?-1:1;
+		if (data["x"].getString() == "TRADE") {
+			std::unique_lock<std::mutex> _(lock);
+			auto iter = assets.find(std::string(symb.data, symb.length));
+			//fills of pairs which are not watched are not recorded, they are not synchronized yet
+			if (iter != assets.end()) {
+				auto trade = spotTrade(data["t"], data["T"].getUIntLong(), side*data["l"].getNumber(),
+						data["L"].getNumber(), data["n"].getNumber(), data["N"].getString(),
+						iter->second.first, iter->second.second);
+				_.unlock();
+				state.addFill(symb, trade);
+				if (onFill) onFill(symb);
+			}
+		}
+		if (status == "NEW" || status == "PARTIALLY_FILLED") {
+			state.updateOrder(symb, StreamState::Order{
+				data["i"],
+				extractOrderID(data["c"].getString()),
+				side*(data["q"].getNumber() - data["z"].getNumber()),
+				data["p"].getNumber()
+			});
+		} else {
+			state.removeOrder(symb, data["i"]);
+		}
+	} else if (e == "listenKeyExpired") {
+		return false;
+	}
+	return true;
+}
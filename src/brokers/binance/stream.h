@@ -0,0 +1,59 @@
+/*
+ * stream.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_BROKERS_BINANCE_STREAM_H_
+#define SRC_BROKERS_BINANCE_STREAM_H_
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <imtjson/value.h>
+#include "../market_stream.h"
+#include "proxy.h"
+
+///Default url of the binance spot stream
+static constexpr const char *binanceStreamUrl = "wss://stream.binance.com:9443";
+
+///Protocol of binance spot stream (combined stream of user data and tickers)
+class BinanceStream: public IStreamProtocol {
+public:
+	BinanceStream(Proxy &px, std::string wsUrl):px(px),wsUrl(std::move(wsUrl)) {}
+
+	virtual std::string getUrl() override;
+	virtual void onConnect(MarketStream &) override {}
+	virtual void subscribe(MarketStream &stream, const std::string &symbol) override;
+	virtual bool onMessage(const json::Value &msg, StreamState &state) override;
+
+	///Registers symbols of the pair (needed to calculate effective size and price of fills)
+	void watch(const std::string_view &pair, const std::string &asset, const std::string &currency);
+	///Extends validity of the listen key (called periodically)
+	void keepAlive();
+	///Called when an order of a watched pair has been executed (from the thread of the stream)
+	std::function<void(const std::string_view &symbol)> onFill;
+
+protected:
+	Proxy &px;
+	std::string wsUrl;
+	std::mutex lock;
+	std::string listenKey;
+	std::chrono::steady_clock::time_point keepAliveTime;
+	unsigned int reqId = 1;
+	std::unordered_map<std::string, std::pair<std::string, std::string> > assets;
+};
+
+///Creates spot trade, commission is included in effective size or price
+IStockApi::Trade spotTrade(json::Value id, std::uint64_t time, double size, double price,
+		double comms, json::StrViewA comass, json::StrViewA asset, json::StrViewA currency);
+
+///Extracts client's id from the id of the order
+json::Value extractOrderID(json::StrViewA id);
+
+
+#endif /* SRC_BROKERS_BINANCE_STREAM_H_ */
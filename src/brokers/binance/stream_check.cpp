@@ -0,0 +1,113 @@
+/*
+ * stream_check.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+#include <imtjson/value.h>
+#include "stream.h"
+
+using json::Value;
+
+///Replays recorded stream and checks the resulting StreamState
+/**
+ * Usage: binance_stream_check <recording.jsonl> <expectation.json>
+ *
+ * The recording contains one message per line (as recorded by MarketStream::setRecordFile).
+ * The expectation describes the state before the replay and the expected state after it
+ *
+ * @code
+ * {
+ *    "watch": {"<symbol>":["<asset>","<currency>"]},  //symbols registered to the protocol
+ *    "orders": ["<symbol>"],                          //symbols which have no open orders before the replay
+ *    "anchors": {"<symbol>": <lastId>},               //last trade id retrieved by REST
+ *    "expect": {
+ *        "orders": {"<symbol>": [<order id>,...]},
+ *        "trades": {"<symbol>": {"ids":[<trade id>,...], "lastId":<lastId>}},
+ *        "tickers": {"<symbol>": <last price>}
+ *    }
+ * }
+ * @endcode
+ *
+ * Prints mismatches and returns non-zero exit code, if the state doesn't match
+ */
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		std::cerr << "Usage: " << argv[0] << " <recording.jsonl> <expectation.json>" << std::endl;
+		return 1;
+	}
+	try {
+		std::ifstream rec(argv[1]);
+		if (!rec) throw std::runtime_error(std::string("Can't open: ") + argv[1]);
+		std::ifstream expf(argv[2]);
+		if (!expf) throw std::runtime_error(std::string("Can't open: ") + argv[2]);
+		Value exp = Value::fromStream(expf);
+
+		//proxy is not used during the replay
+		Proxy px("https://api.binance.com", "/api/v3/time");
+		BinanceStream proto(px, binanceStreamUrl);
+		StreamState state;
+		state.connected();
+		for (Value w: exp["watch"]) {
+			proto.watch(w.getKey(), w[0].toString().str(), w[1].toString().str());
+		}
+		for (Value s: exp["orders"]) {
+			auto symb = s.getString();
+			state.setOrders(symb, {}, state.getOrdersVersion(symb));
+		}
+		for (Value a: exp["anchors"]) {
+			state.anchorTrades(a.getKey(), a, state.getEpoch());
+		}
+
+		MarketStream::replay(rec, proto, state);
+
+		int errors = 0;
+		auto report = [&](const std::string_view &what, const std::string_view &symbol, Value expected, Value got) {
+			std::cout << "MISMATCH " << what << " " << symbol << ": expected " << expected.toString()
+					<< ", got " << got.toString() << std::endl;
+			errors++;
+		};
+		Value expect = exp["expect"];
+		for (Value o: expect["orders"]) {
+			auto symb = o.getKey();
+			auto orders = state.getOrders(symb);
+			Value got = orders.has_value()
+					?Value(json::array, orders->begin(), orders->end(), [](const auto &x){return x.id;})
+					:Value(nullptr);
+			if (got.stripKey() != o.stripKey()) report("orders", symb, o, got);
+		}
+		for (Value t: expect["trades"]) {
+			auto symb = t.getKey();
+			//anchors are not moved by the replay, so the first sync uses the initial anchor
+			auto sync = state.syncTrades(exp["anchors"][symb], symb);
+			Value got = sync.has_value()
+					?Value(json::Object
+							("ids", Value(json::array, sync->trades.begin(), sync->trades.end(), [](const auto &x){return x.id;}))
+							("lastId", sync->lastId))
+					:Value(nullptr);
+			if (got.stripKey() != t.stripKey()) report("trades", symb, t, got);
+		}
+		for (Value k: expect["tickers"]) {
+			auto symb = k.getKey();
+			auto tk = state.getTicker(symb);
+			Value got = tk.has_value()?Value(tk->last):Value(nullptr);
+			if (got.getNumber() != k.getNumber()) report("ticker", symb, k, got);
+		}
+		if (errors) {
+			std::cout << "FAILED: " << errors << " mismatch(es)" << std::endl;
+			return 2;
+		}
+		std::cout << "OK" << std::endl;
+		return 0;
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -9,6 +9,13 @@
 #include <imtjson/parser.h>
 #include "httpjson.h"
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include <simpleServer/urlencode.h>
 #include "../shared/logOutput.h"
 #include "log.h"
@@ -16,12 +23,97 @@
 using ondra_shared::logDebug;
 using simpleServer::urlEncode;
 
+///Pool of persistent (keep-alive) connections
+/**
+ * Each connection is a copy of the prototype HttpClient, which keeps its connection
+ * open between requests. Connections are grouped by host. Idle connections are reused
+ * in LIFO order (the most recently used connection is most likely still open), and
+ * closed after the idle timeout. Count of connections per host is limited, requests
+ * above the limit wait for a free connection.
+ */
+class HTTPJson::Pool {
+public:
+
+	using Clock = std::chrono::steady_clock;
+
+	struct Lease {
+		Pool &pool;
+		std::string host;
+		simpleServer::HttpClient client;
+		bool reused;
+		bool keep = false;
+		~Lease() {pool.release(host, std::move(client), keep);}
+	};
+
+	Pool(const PoolConfig &cfg):cfg(cfg) {}
+
+	std::unique_ptr<Lease> acquire(const std::string &host, const simpleServer::HttpClient &proto) {
+		std::unique_lock<std::mutex> _(lock);
+		Host &h = hosts[host];
+		h.cond.wait(_, [&]{
+			evict(h);
+			return !h.idle.empty() || h.active < cfg.max_per_host;
+		});
+		h.active++;
+		if (!h.idle.empty()) {
+			auto c = std::move(h.idle.back().client);
+			h.idle.pop_back();
+			return std::unique_ptr<Lease>(new Lease{*this, host, std::move(c), true});
+		}
+		return std::unique_ptr<Lease>(new Lease{*this, host, simpleServer::HttpClient(proto), false});
+	}
+
+	void setConfig(const PoolConfig &c) {
+		std::unique_lock<std::mutex> _(lock);
+		cfg = c;
+		for (auto &h: hosts) h.second.cond.notify_all();
+	}
+
+	void closeIdle() {
+		std::unique_lock<std::mutex> _(lock);
+		for (auto &h: hosts) h.second.idle.clear();
+	}
+
+protected:
+
+	struct Idle {
+		simpleServer::HttpClient client;
+		Clock::time_point since;
+	};
+	struct Host {
+		std::vector<Idle> idle;
+		unsigned int active = 0;
+		///waiters for a connection to this host
+		std::condition_variable cond;
+	};
+
+	PoolConfig cfg;
+	std::mutex lock;
+	std::unordered_map<std::string, Host> hosts;
+
+	void evict(Host &h) {
+		auto limit = Clock::now() - std::chrono::milliseconds(cfg.idle_timeout);
+		auto iter = std::find_if(h.idle.begin(), h.idle.end(), [&](const Idle &x){return x.since >= limit;});
+		h.idle.erase(h.idle.begin(), iter);
+	}
+
+	void release(const std::string &host, simpleServer::HttpClient &&client, bool keep) {
+		std::unique_lock<std::mutex> _(lock);
+		Host &h = hosts[host];
+		h.active--;
+		if (keep && h.idle.size() < cfg.max_per_host) {
+			h.idle.push_back(Idle{std::move(client), Clock::now()});
+		}
+		h.cond.notify_one();
+	}
+};
+
 HTTPJson::HTTPJson(simpleServer::HttpClient &&httpc,
 		const std::string_view &baseUrl)
-:httpc(std::move(httpc)),baseUrl(baseUrl)
+:httpc(std::move(httpc)),baseUrl(baseUrl),pool(std::make_shared<Pool>(PoolConfig()))
 {
-	httpc.setConnectTimeout(5000);
-	httpc.setIOTimeout(10000);
+	this->httpc.setConnectTimeout(5000);
+	this->httpc.setIOTimeout(10000);
 }
 
 
@@ -41,7 +133,7 @@ static simpleServer::SendHeaders hdrs(const json::Value &headers) {
 		}
 
 	}
-	hdr("Connection","close");
+	hdr("Connection","keep-alive");
 	if (!headers["Accept"].defined()) hdr("Accept","application/json");
 	return hdr;
 }
@@ -56,7 +148,11 @@ json::Value parseResponse(simpleServer::HttpResponse &resp, json::Value &headers
 		hh.set(name, k.second);
 	}
 	if (ctx.indexOf("application/json") != ctx.npos) {
-		r = json::Value::parse(resp.getBody());
+		auto s = resp.getBody();
+		r = json::Value::parse(s);
+		//rest of the body must be read, otherwise the connection can't be reused
+		BinaryView b = s.read();
+		while (!b.empty()) b = s.read();
 	} else {
 		std::ostringstream buff;
 		auto s = resp.getBody();
@@ -78,12 +174,7 @@ json::Value HTTPJson::GET(const std::string_view &path, json::Value &&headers, u
 
 	logDebug("GET $1", url);
 
-	auto resp = httpc.request("GET", url, hdrs(headers));
-	unsigned int st = resp.getStatus();
-	if ((expectedCode && st != expectedCode) || (!expectedCode && st/100 != 2)) {
-		throw UnknownStatusException(st, resp.getMessage(),resp);
-	}
-	json::Value r = parseResponse(resp, headers);
+	json::Value r = request("GET", url, headers, nullptr, expectedCode);
 	logDebug("RECV: $1", r);
 	return r;
 }
@@ -109,12 +200,7 @@ json::Value HTTPJson::SEND(const std::string_view &path,
 	logDebug("$1 $2 - data $3", method, url, data);
 
 
-	auto resp = httpc.request(method, url, hdrs(headers), sdata.str());
-	unsigned int st = resp.getStatus();
-	if ((expectedCode && st != expectedCode) || (!expectedCode && st/100 != 2)) {
-		throw UnknownStatusException(st, resp.getMessage(), resp);
-	}
-	json::Value r = parseResponse(resp, headers);
+	json::Value r = request(method, url, headers, &sdata, expectedCode);
 	logDebug("RECV: $1", r);
 	return r;
 
@@ -138,3 +224,45 @@ json::Value HTTPJson::DELETE(const std::string_view &path,
 void HTTPJson::setBaseUrl(const std::string &url) {
 	baseUrl = url;
 }
+
+void HTTPJson::setPoolConfig(const PoolConfig &cfg) {
+	pool->setConfig(cfg);
+}
+
+void HTTPJson::closeIdle() {
+	pool->closeIdle();
+}
+
+///Extracts scheme, host and port from the url
+static std::string hostKey(const std::string &url) {
+	auto p = url.find("://");
+	p = p == url.npos?0:p+3;
+	return url.substr(0, url.find('/', p));
+}
+
+json::Value HTTPJson::request(const std::string_view &method, const std::string &url,
+		json::Value &headers, const json::String *body, unsigned int expectedCode) {
+	std::string host = hostKey(url);
+	//stale connection can be detected only by sending the request, so only requests
+	//which can be repeated are retried
+	bool can_retry = method == "GET";
+	while (true) {
+		auto lease = pool->acquire(host, httpc);
+		try {
+			auto resp = body?lease->client.request(method, url, hdrs(headers), body->str())
+							:lease->client.request(method, url, hdrs(headers));
+			unsigned int st = resp.getStatus();
+			if ((expectedCode && st != expectedCode) || (!expectedCode && st/100 != 2)) {
+				throw UnknownStatusException(st, resp.getMessage(), resp);
+			}
+			json::Value r = parseResponse(resp, headers);
+			lease->keep = headers["connection"].getString() != "close";
+			return r;
+		} catch (UnknownStatusException &) {
+			throw;
+		} catch (std::exception &e) {
+			if (!lease->reused || !can_retry) throw;
+			logDebug("Persistent connection to $1 failed, retrying: $2", host, e.what());
+		}
+	}
+}
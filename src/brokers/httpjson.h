@@ -8,7 +8,9 @@
 #ifndef SRC_SIMPLEFX_HTTPJSON_H_
 #define SRC_SIMPLEFX_HTTPJSON_H_
 
+#include <memory>
 #include <string_view>
+#include <imtjson/string.h>
 #include <imtjson/value.h>
 #include <simpleServer/http_client.h>
 
@@ -59,9 +61,29 @@ public:
 
 	void setBaseUrl(const std::string &url);
 
+	///Configuration of the pool of persistent connections
+	struct PoolConfig {
+		///maximum count of connections per host (requests above the limit wait)
+		unsigned int max_per_host = 4;
+		///idle connections are closed after this time (milliseconds)
+		unsigned int idle_timeout = 20000;
+	};
+
+	///Changes configuration of the pool
+	void setPoolConfig(const PoolConfig &cfg);
+	///Closes all idle connections
+	void closeIdle();
+
+	class Pool;
+
 protected:
+	///prototype of connections - every new connection is a copy of this object
 	simpleServer::HttpClient httpc;
 	std::string baseUrl;
+	std::shared_ptr<Pool> pool;
+
+	json::Value request(const std::string_view &method, const std::string &url,
+			json::Value &headers, const json::String *body, unsigned int expectedCode);
 
 };
 
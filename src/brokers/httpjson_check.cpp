@@ -0,0 +1,160 @@
+/*
+ * httpjson_check.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <simpleServer/http_client.h>
+#include "httpjson.h"
+
+///Minimal local HTTP server (keep-alive), which counts accepted connections
+/**
+ * Paths:
+ * /json - JSON response followed by whitespace (inside of the body), keeps the connection
+ * /close - JSON response with Connection: close
+ */
+class LocalServer {
+public:
+	LocalServer() {
+		sock = ::socket(AF_INET, SOCK_STREAM, 0);
+		int one = 1;
+		setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		if (::bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) || ::listen(sock, 16))
+			throw std::runtime_error("Unable to open the local server");
+		socklen_t len = sizeof(addr);
+		getsockname(sock, reinterpret_cast<sockaddr *>(&addr), &len);
+		port = ntohs(addr.sin_port);
+		thr = std::thread([this]{acceptLoop();});
+	}
+	~LocalServer() {
+		::shutdown(sock, SHUT_RDWR);
+		::close(sock);
+		thr.join();
+		dropConnections();
+		for (auto &t: workers) t.join();
+	}
+
+	std::string url() const {return "http://127.0.0.1:" + std::to_string(port);}
+	unsigned int accepted() const {return counter;}
+
+	///Closes all open connections (simulates server side timeout)
+	void dropConnections() {
+		std::lock_guard<std::mutex> _(lock);
+		for (int c: conns) ::shutdown(c, SHUT_RDWR);
+	}
+
+protected:
+	int sock;
+	int port;
+	std::thread thr;
+	std::atomic<unsigned int> counter = 0;
+	std::mutex lock;
+	std::vector<int> conns;
+	std::vector<std::thread> workers;
+
+	void acceptLoop() {
+		while (true) {
+			int c = ::accept(sock, nullptr, nullptr);
+			if (c < 0) break;
+			counter++;
+			std::lock_guard<std::mutex> _(lock);
+			conns.push_back(c);
+			workers.emplace_back([this, c]{serve(c);});
+		}
+	}
+
+	void serve(int c) {
+		std::string buff;
+		char tmp[4096];
+		while (true) {
+			auto p = buff.find("\r\n\r\n");
+			if (p == buff.npos) {
+				int r = ::recv(c, tmp, sizeof(tmp), 0);
+				if (r <= 0) break;
+				buff.append(tmp, r);
+				continue;
+			}
+			std::string hdr = buff.substr(0, p);
+			buff.erase(0, p+4);
+			bool close = hdr.find(" /close ") != hdr.npos;
+			std::string body = "{\"ok\":true}\n\n    \n";
+			std::string resp = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: "
+					+ std::to_string(body.size()) + "\r\n"
+					+ (close?"Connection: close\r\n":"Connection: keep-alive\r\n")
+					+ "\r\n" + body;
+			::send(c, resp.data(), resp.size(), MSG_NOSIGNAL);
+			if (close) break;
+		}
+		::shutdown(c, SHUT_RDWR);
+		std::lock_guard<std::mutex> _(lock);
+		conns.erase(std::remove(conns.begin(), conns.end(), c), conns.end());
+		::close(c);
+	}
+};
+
+///Checks the pool of persistent connections of HTTPJson against local server
+/**
+ * Usage: httpjson_check
+ *
+ * Checks reuse of the connection (the rest of the body is drained), idle eviction,
+ * retry of GET on stale connection and Connection: close. Prints results and
+ * returns non-zero exit code on failure
+ */
+int main(int, char **) {
+	signal(SIGPIPE, SIG_IGN);
+	int errors = 0;
+	auto check = [&](const char *name, bool ok) {
+		std::cout << (ok?"OK     ":"FAILED ") << name << std::endl;
+		if (!ok) errors++;
+	};
+	try {
+		LocalServer srv;
+		HTTPJson api(simpleServer::HttpClient("httpjson_check",
+				simpleServer::newHttpsProvider(),
+				simpleServer::newNoProxyProvider()), srv.url());
+
+		bool ok = true;
+		for (int i = 0; i < 3; i++) ok = ok && api.GET("/json")["ok"].getBool();
+		check("responses", ok);
+		check("connection reused", srv.accepted() == 1);
+
+		api.setPoolConfig({4, 100});
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		api.GET("/json");
+		check("idle connection evicted", srv.accepted() == 2);
+
+		api.setPoolConfig({4, 20000});
+		srv.dropConnections();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		check("stale connection retried", api.GET("/json")["ok"].getBool());
+		check("new connection after stale", srv.accepted() == 3);
+
+		api.GET("/close");
+		api.GET("/json");
+		check("connection: close not reused", srv.accepted() == 4);
+	} catch (std::exception &e) {
+		std::cout << "FAILED " << e.what() << std::endl;
+		errors++;
+	}
+	return errors?2:0;
+}
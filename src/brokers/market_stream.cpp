@@ -0,0 +1,132 @@
+/*
+ * market_stream.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "market_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <imtjson/parser.h>
+#include <shared/logOutput.h>
+#include "log.h"
+
+using ondra_shared::logDebug;
+using ondra_shared::logError;
+using ondra_shared::logWarning;
+
+MarketStream::MarketStream(simpleServer::HttpClient &&httpc, IStreamProtocol &protocol, StreamState &state)
+:httpc(std::move(httpc)),protocol(protocol),state(state)
+{
+}
+
+MarketStream::~MarketStream() {
+	stop();
+}
+
+void MarketStream::start() {
+	Sync _(lock);
+	if (thr.joinable()) return;
+	stopped = false;
+	thr = std::thread([this]{worker();});
+}
+
+void MarketStream::stop() {
+	Sync _(lock);
+	if (!thr.joinable()) return;
+	stopped = true;
+	if (connected) ws.close();
+	wakeup.notify_all();
+	_.unlock();
+	thr.join();
+}
+
+void MarketStream::subscribe(const std::string_view &symbol) {
+	Sync _(lock);
+	std::string s(symbol);
+	if (subscribed.find(s) != subscribed.end()) return;
+	subscribed.insert(s);
+	if (connected) protocol.subscribe(*this, s);
+}
+
+bool MarketStream::send(const json::Value &msg) {
+	Sync _(lock);
+	if (!connected) return false;
+	ws.postText(msg.stringify());
+	return true;
+}
+
+void MarketStream::setRecordFile(const std::string &path) {
+	Sync _(lock);
+	record.close();
+	record.clear();
+	if (!path.empty()) record.open(path, std::ios::out|std::ios::app);
+}
+
+void MarketStream::worker() {
+	unsigned int delay = 1;
+	while (!stopped) {
+		try {
+			std::string url = protocol.getUrl();
+			logDebug("Opening stream: $1", url);
+			auto s = simpleServer::connectWebSocket(httpc, url, simpleServer::SendHeaders());
+			s.getStream().setIOTimeout(60000);
+			{
+				Sync _(lock);
+				if (stopped) {
+					s.close();
+					break;
+				}
+				ws = s;
+				connected = true;
+				state.connected();
+				protocol.onConnect(*this);
+				for (auto &&x: subscribed) protocol.subscribe(*this, x);
+			}
+			delay = 1;
+			processMessages();
+		} catch (std::exception &e) {
+			logError("Stream error: $1", e.what());
+		}
+		{
+			Sync _(lock);
+			connected = false;
+			state.disconnected();
+			ws = simpleServer::WebSocketStream();
+			if (stopped) break;
+			logWarning("Stream closed - reconnect in $1 s", delay);
+			wakeup.wait_for(_, std::chrono::seconds(delay));
+		}
+		delay = std::min(delay * 2, 60U);
+	}
+}
+
+void MarketStream::processMessages() {
+	while (!stopped && ws.readFrame()) {
+		if (ws.getFrameType() != simpleServer::WSFrameType::text) continue;
+		try {
+			json::Value msg = json::Value::fromString(ws.getText());
+			{
+				Sync _(lock);
+				if (record.is_open()) record << msg.stringify() << std::endl;
+			}
+			if (!protocol.onMessage(msg, state)) {
+				logWarning("Stream requested reconnect");
+				break;
+			}
+		} catch (std::exception &e) {
+			logError("Exception: $1 (discarded frame: $2)", e.what(), ws.getText());
+		}
+	}
+}
+
+void MarketStream::replay(std::istream &in, IStreamProtocol &protocol, StreamState &state) {
+	state.connected();
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty()) continue;
+		if (!protocol.onMessage(json::Value::fromString(line), state)) break;
+	}
+}
@@ -0,0 +1,106 @@
+/*
+ * market_stream.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_BROKERS_MARKET_STREAM_H_
+#define SRC_BROKERS_MARKET_STREAM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <shared/linear_set.h>
+#include <simpleServer/http_client.h>
+#include <simpleServer/websockets_stream.h>
+
+#include "stream_state.h"
+
+class MarketStream;
+
+///Protocol of the exchange's stream
+class IStreamProtocol {
+public:
+	///Returns url of the websocket stream
+	/** Called before each connection, so it can perform negotiation (for example, request a listen key) */
+	virtual std::string getUrl() = 0;
+	///Called when the connection is established, before subscriptions are restored
+	virtual void onConnect(MarketStream &stream) = 0;
+	///Subscribes the symbol (sends a message through MarketStream::send)
+	virtual void subscribe(MarketStream &stream, const std::string &symbol) = 0;
+	///Processes message
+	/**
+	 * @param msg parsed message
+	 * @param state state to update
+	 * @retval true continue
+	 * @retval false close the connection and reconnect
+	 */
+	virtual bool onMessage(const json::Value &msg, StreamState &state) = 0;
+	virtual ~IStreamProtocol() {}
+};
+
+///Websocket stream of market and user data
+/**
+ * Generalization of the QuoteStream (simplefx). The stream runs in own thread, it is
+ * reconnected automatically, when the connection is lost, and the subscriptions are
+ * restored. Messages are parsed by the protocol, which updates the StreamState. When the
+ * stream is disconnected, the state is invalidated, so the broker falls back to REST
+ * until the state is synchronized again.
+ *
+ * Received messages can be recorded to a file (one JSON per line) and replayed later
+ * without the connection. The protocol can also return url of a local server, which
+ * replays recorded messages.
+ */
+class MarketStream {
+public:
+
+	MarketStream(simpleServer::HttpClient &&httpc, IStreamProtocol &protocol, StreamState &state);
+	~MarketStream();
+
+	///Starts the stream (connection is established in the background)
+	void start();
+	///Stops the stream
+	void stop();
+	///Subscribes the symbol (once, the subscription is restored after reconnect)
+	void subscribe(const std::string_view &symbol);
+	///Sends message
+	/** @retval false not connected */
+	bool send(const json::Value &msg);
+	///Records all received messages to the file
+	void setRecordFile(const std::string &path);
+
+	///Replays recorded messages
+	/**
+	 * @param in stream with recorded messages (one JSON per line)
+	 * @param protocol protocol
+	 * @param state state to update. The state is marked connected
+	 */
+	static void replay(std::istream &in, IStreamProtocol &protocol, StreamState &state);
+
+protected:
+
+	simpleServer::HttpClient httpc;
+	IStreamProtocol &protocol;
+	StreamState &state;
+
+	simpleServer::WebSocketStream ws;
+	std::thread thr;
+	std::recursive_mutex lock;
+	using Sync = std::unique_lock<std::recursive_mutex>;
+	std::condition_variable_any wakeup;
+	std::atomic<bool> stopped = false;
+	bool connected = false;
+	ondra_shared::linear_set<std::string> subscribed;
+	std::ofstream record;
+
+	void worker();
+	void processMessages();
+};
+
+
+#endif /* SRC_BROKERS_MARKET_STREAM_H_ */
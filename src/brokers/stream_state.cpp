@@ -0,0 +1,145 @@
+/*
+ * stream_state.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "stream_state.h"
+
+#include <algorithm>
+
+void StreamState::connected() {
+	std::lock_guard<std::mutex> _(lock);
+	is_connected = true;
+	epoch++;
+	if (epoch == 0) epoch++;
+}
+
+void StreamState::disconnected() {
+	std::lock_guard<std::mutex> _(lock);
+	is_connected = false;
+	for (auto &s: symbols) {
+		Symbol &sm = s.second;
+		sm.ticker.reset();
+		sm.orders_valid = false;
+		sm.orders_version++;
+		sm.orders.clear();
+		sm.anchored = false;
+		sm.fills.clear();
+	}
+}
+
+bool StreamState::isConnected() const {
+	std::lock_guard<std::mutex> _(lock);
+	return is_connected;
+}
+
+unsigned int StreamState::getEpoch() const {
+	std::lock_guard<std::mutex> _(lock);
+	return is_connected?epoch:0;
+}
+
+StreamState::Symbol &StreamState::getSymbol(const std::string_view &symbol) {
+	auto iter = symbols.find(std::string(symbol));
+	if (iter == symbols.end()) iter = symbols.emplace(std::string(symbol), Symbol()).first;
+	return iter->second;
+}
+
+const StreamState::Symbol *StreamState::findSymbol(const std::string_view &symbol) const {
+	auto iter = symbols.find(std::string(symbol));
+	if (iter == symbols.end()) return nullptr;
+	return &iter->second;
+}
+
+void StreamState::updateTicker(const std::string_view &symbol, const Ticker &tk) {
+	std::lock_guard<std::mutex> _(lock);
+	if (!is_connected) return;
+	getSymbol(symbol).ticker = tk;
+}
+
+std::optional<StreamState::Ticker> StreamState::getTicker(const std::string_view &symbol) const {
+	std::lock_guard<std::mutex> _(lock);
+	const Symbol *s = findSymbol(symbol);
+	if (s == nullptr || !is_connected) return {};
+	return s->ticker;
+}
+
+std::uint64_t StreamState::getOrdersVersion(const std::string_view &symbol) const {
+	std::lock_guard<std::mutex> _(lock);
+	const Symbol *s = findSymbol(symbol);
+	return s?s->orders_version:0;
+}
+
+void StreamState::setOrders(const std::string_view &symbol, const Orders &orders, std::uint64_t version) {
+	std::lock_guard<std::mutex> _(lock);
+	if (!is_connected) return;
+	Symbol &s = getSymbol(symbol);
+	if (s.orders_version != version) return;
+	s.orders = orders;
+	s.orders_valid = true;
+}
+
+void StreamState::updateOrder(const std::string_view &symbol, const Order &order) {
+	std::lock_guard<std::mutex> _(lock);
+	if (!is_connected) return;
+	Symbol &s = getSymbol(symbol);
+	s.orders_version++;
+	auto iter = std::find_if(s.orders.begin(), s.orders.end(), [&](const Order &o) {
+		return o.id == order.id;
+	});
+	if (iter == s.orders.end()) s.orders.push_back(order);
+	else *iter = order;
+}
+
+void StreamState::removeOrder(const std::string_view &symbol, const json::Value &id) {
+	std::lock_guard<std::mutex> _(lock);
+	if (!is_connected) return;
+	Symbol &s = getSymbol(symbol);
+	s.orders_version++;
+	s.orders.erase(std::remove_if(s.orders.begin(), s.orders.end(), [&](const Order &o) {
+		return o.id == id;
+	}), s.orders.end());
+}
+
+std::optional<StreamState::Orders> StreamState::getOrders(const std::string_view &symbol) const {
+	std::lock_guard<std::mutex> _(lock);
+	const Symbol *s = findSymbol(symbol);
+	if (s == nullptr || !is_connected || !s->orders_valid) return {};
+	return s->orders;
+}
+
+void StreamState::addFill(const std::string_view &symbol, const Trade &trade) {
+	std::lock_guard<std::mutex> _(lock);
+	if (!is_connected) return;
+	Symbol &s = getSymbol(symbol);
+	if (s.anchored && json::Value::compare(trade.id, s.anchor) <= 0) return;
+	s.fills.push_back(trade);
+}
+
+void StreamState::anchorTrades(const std::string_view &symbol, const json::Value &lastId, unsigned int epoch) {
+	std::lock_guard<std::mutex> _(lock);
+	if (!is_connected || epoch != this->epoch || !lastId.hasValue()) return;
+	Symbol &s = getSymbol(symbol);
+	s.fills.erase(std::remove_if(s.fills.begin(), s.fills.end(), [&](const Trade &t) {
+		return json::Value::compare(t.id, lastId) <= 0;
+	}), s.fills.end());
+	s.anchor = lastId;
+	s.anchored = true;
+}
+
+std::optional<StreamState::TradesSync> StreamState::syncTrades(const json::Value &lastId, const std::string_view &symbol) {
+	std::lock_guard<std::mutex> _(lock);
+	if (!is_connected) return {};
+	Symbol &s = getSymbol(symbol);
+	if (!s.anchored || s.anchor != lastId) return {};
+	TradesSync res;
+	res.trades = std::move(s.fills);
+	s.fills.clear();
+	std::sort(res.trades.begin(), res.trades.end(), [](const Trade &a, const Trade &b) {
+		return json::Value::compare(a.id, b.id) < 0;
+	});
+	if (!res.trades.empty()) s.anchor = res.trades.back().id;
+	res.lastId = s.anchor;
+	return res;
+}
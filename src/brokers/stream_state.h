@@ -0,0 +1,107 @@
+/*
+ * stream_state.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_BROKERS_STREAM_STATE_H_
+#define SRC_BROKERS_STREAM_STATE_H_
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../main/istockapi.h"
+
+///Market and user data received from the stream
+/**
+ * Keeps live tickers, open orders and fills per symbol. Data are valid only while the
+ * stream is connected. After the connection is established, open orders and trades must
+ * be synchronized by REST first (setOrders(), anchorTrades()), then they are
+ * maintained by the stream. Functions which return std::optional return no value, if
+ * the data are not available. The broker should use REST in this case.
+ *
+ * Trade ids must be increasing (compared by json::Value::compare)
+ *
+ * All functions are MT safe
+ */
+class StreamState {
+public:
+
+	using Ticker = IStockApi::Ticker;
+	using Order = IStockApi::Order;
+	using Orders = IStockApi::Orders;
+	using Trade = IStockApi::Trade;
+	using TradesSync = IStockApi::TradesSync;
+
+	///Called when the stream is connected
+	void connected();
+	///Called when the stream is disconnected - all data become invalid
+	void disconnected();
+	bool isConnected() const;
+	///Returns id of current connection, or zero if not connected
+	unsigned int getEpoch() const;
+
+	void updateTicker(const std::string_view &symbol, const Ticker &tk);
+	std::optional<Ticker> getTicker(const std::string_view &symbol) const;
+
+	///Returns version of open orders. Call it before the orders are requested by REST
+	std::uint64_t getOrdersVersion(const std::string_view &symbol) const;
+	///Sets open orders retrieved by REST
+	/**
+	 * @param symbol symbol
+	 * @param orders open orders
+	 * @param version version returned by getOrdersVersion() before the request. If the orders
+	 * has been changed by the stream meanwhile, the function does nothing
+	 */
+	void setOrders(const std::string_view &symbol, const Orders &orders, std::uint64_t version);
+	///Creates or updates open order
+	void updateOrder(const std::string_view &symbol, const Order &order);
+	///Removes order (filled or canceled)
+	void removeOrder(const std::string_view &symbol, const json::Value &id);
+	std::optional<Orders> getOrders(const std::string_view &symbol) const;
+
+	///Records fill
+	void addFill(const std::string_view &symbol, const Trade &trade);
+	///Sets last trade id retrieved by REST
+	/**
+	 * Fills with id less or equal to the lastId are dropped, because they are already
+	 * reported. Next syncTrades() with this lastId can be answered from the stream
+	 *
+	 * @param symbol symbol
+	 * @param lastId lastId returned by REST
+	 * @param epoch value of getEpoch() before the request. If the stream has been reconnected
+	 * meanwhile, the function does nothing
+	 */
+	void anchorTrades(const std::string_view &symbol, const json::Value &lastId, unsigned int epoch);
+	///Returns new fills since lastId
+	std::optional<TradesSync> syncTrades(const json::Value &lastId, const std::string_view &symbol);
+
+protected:
+
+	struct Symbol {
+		std::optional<Ticker> ticker;
+		bool orders_valid = false;
+		std::uint64_t orders_version = 0;
+		Orders orders;
+		bool anchored = false;
+		json::Value anchor;
+		std::vector<Trade> fills;
+	};
+
+	mutable std::mutex lock;
+	std::unordered_map<std::string, Symbol> symbols;
+	bool is_connected = false;
+	unsigned int epoch = 0;
+
+	Symbol &getSymbol(const std::string_view &symbol);
+	const Symbol *findSymbol(const std::string_view &symbol) const;
+};
+
+
+#endif /* SRC_BROKERS_STREAM_STATE_H_ */
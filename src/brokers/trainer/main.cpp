@@ -25,6 +25,7 @@
 #include <shared/stringview.h>
 #include "../bitfinex/structs.h"
 #include "cryptowatch.h"
+#include "../../pricegen/price_generator.h"
 
 using json::Object;
 using json::Value;
@@ -1392,6 +1393,30 @@ Interface::PageData Interface::fetchPage(const std::string_view &method, const s
 			for (auto &&p : prices) s << p << std::endl;
 			return Interface::PageData {200,{{"Content-Type","application/octet-stream"}},s.str()};
 		}
+		if (vpath.substr(0,11) == "/synthetic-") {
+			//offline generator: /synthetic-<model>-<days>-<seed>[-<volatility%>]
+			StrViewA req (vpath.substr(11));
+			auto splt = req.split("-");
+			StrViewA m = splt();
+			std::string model(m.data, m.length);
+			unsigned long days = std::strtoul(splt().data, nullptr, 10);
+			unsigned int seed = std::strtoul(splt().data, nullptr, 10);
+			double volatility = !!splt?std::strtod(splt().data, nullptr)*0.01:0.8;
+			//limited to five years, count of minutes must not overflow and the response must fit to the memory
+			static const unsigned long max_days = 5*366;
+			if (days == 0 || days > max_days) {
+				return Interface::PageData {400,{{"Content-Type","text/plain"}},"Days must be between 1 and "+std::to_string(max_days)};
+			}
+			try {
+				auto gen = createPriceGenerator(model, volatility);
+				auto prices = gen->generate(1.0, days * 1440, seed);
+				std::ostringstream s;
+				for (auto &&p : prices) s << p << std::endl;
+				return Interface::PageData {200,{{"Content-Type","application/octet-stream"}},s.str()};
+			} catch (std::exception &e) {
+				return Interface::PageData {400,{{"Content-Type","text/plain"}},e.what()};
+			}
+		}
 	}
 
 	return Interface::PageData {404,{},""};
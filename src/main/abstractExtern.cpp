@@ -171,6 +171,8 @@ void AbstractExtern::spawn() {
 				extin = std::move(proc_input.write);
 				chldid = frk;
 				houseKeepingCounter = 0;
+				binary = false;
+				tagged = false;
 			}
 		});
 	}
@@ -208,6 +210,7 @@ void AbstractExtern::kill() {
 		}
 		chldid = -1;
 	}
+	stopReaderThread();
 }
 
 AbstractExtern::~AbstractExtern() {
@@ -242,6 +245,14 @@ public:
 	void putback(std::string_view data) {
 		buff = data;
 	}
+	///Returns true, if there are data in the buffer
+	bool hasData() const {
+		return !buff.empty();
+	}
+	///Skips whitespaces in the buffer (doesn't read from the stream)
+	void skipWhitespace() {
+		while (!buff.empty() && isspace(buff[0])) buff = buff.substr(1);
+	}
 
 	int operator()() {
 		auto d = read();
@@ -266,10 +277,7 @@ protected:
 };
 
 
-bool AbstractExtern::writeJSON(json::Value v, FD& fd, int timeout) {
-	auto s = v.stringify();
-	s = s + "\n";
-	std::string_view ss(s.c_str(),s.length());
+static bool writeAll(int fd, std::string_view ss, int timeout) {
 	while (!ss.empty()) {
 		waitForWrite(fd, timeout);
 		int i = write(fd, ss.data(), ss.length());
@@ -281,6 +289,21 @@ bool AbstractExtern::writeJSON(json::Value v, FD& fd, int timeout) {
 	return true;
 }
 
+bool AbstractExtern::writeJSON(json::Value v, FD& fd, int timeout, bool binary) {
+	if (binary) {
+		//4 bytes of length (little endian) followed by binary serialized JSON
+		std::string buff(4,0);
+		v.serializeBinary([&](char c){buff.push_back(c);}, json::compressKeys);
+		std::uint32_t len = buff.length()-4;
+		for (int i = 0; i < 4; i++) buff[i] = static_cast<char>((len >> (i*8)) & 0xFF);
+		return writeAll(fd, buff, timeout);
+	} else {
+		auto s = v.stringify();
+		s = s + "\n";
+		return writeAll(fd, std::string_view(s.c_str(),s.length()), timeout);
+	}
+}
+
 void AbstractExtern::housekeeping(int counter) {
 	Sync _(lock);
 	if (chldid != -1) {
@@ -294,8 +317,31 @@ void AbstractExtern::housekeeping(int counter) {
 	}
 }
 
-json::Value AbstractExtern::readJSON(FD& fd, int timeout) {
-	return json::Value::parse(Reader(fd, timeout));
+static void readAll(int fd, char *buff, std::size_t size, int timeout) {
+	while (size) {
+		waitForRead(fd, timeout);
+		int i = ::read(fd, buff, size);
+		if (i < 1) throw std::runtime_error("Connection to API lost");
+		buff += i;
+		size -= i;
+	}
+}
+
+json::Value AbstractExtern::readJSON(FD& fd, int timeout, bool binary) {
+	if (binary) {
+		unsigned char hdr[4];
+		readAll(fd, reinterpret_cast<char *>(hdr), 4, timeout);
+		std::uint32_t len = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | (static_cast<std::uint32_t>(hdr[3]) << 24);
+		std::string buff(len, 0);
+		readAll(fd, buff.data(), len, timeout);
+		std::size_t pos = 0;
+		return json::Value::parseBinary([&]{
+			if (pos >= buff.length()) throw std::runtime_error("Unexpected end of message");
+			return static_cast<int>(static_cast<unsigned char>(buff[pos++]));
+		}, json::base64);
+	} else {
+		return json::Value::parse(Reader(fd, timeout));
+	}
 
 }
 
@@ -326,12 +372,19 @@ json::Value AbstractExtern::jsonExchange(json::Value request, bool idle) {
 	std::string z;
 	std::string lastStdErr;
 
+	//reader of tagged protocol has exited, connection is lost
+	if (chldid != -1 && tagged && !readerRunning) {
+		kill();
+	}
 	if (chldid == -1) {
 		spawn();
 	}
+	if (tagged) {
+		return taggedExchange(request, _);
+	}
 	bool verbose = log.isLogLevelEnabled(ondra_shared::LogLevel::debug);
 	if (verbose) log.debug("SEND: $1", request.toString().substr(0,512));
-	if (writeJSON(request, extin, timeout) == false) {
+	if (writeJSON(request, extin, timeout, binary) == false) {
 		kill();
 	}
 	do {
@@ -372,7 +425,7 @@ json::Value AbstractExtern::jsonExchange(json::Value request, bool idle) {
 				}while (rep);
 			}
 			if (fds[0].revents) {
-					auto ret = readJSON(extout, timeout);
+					auto ret = readJSON(extout, timeout, binary);
 					if (verbose) log.debug("RECV: $1", ret.toString().substr(0,512));
 					return ret;
 
@@ -385,8 +438,158 @@ json::Value AbstractExtern::jsonExchange(json::Value request, bool idle) {
 	while (true);
 }
 
-json::Value AbstractExtern::jsonRequestExchange(json::String name, json::Value args, bool idle) {
+void AbstractExtern::negotiateBinary() {
+	Sync _(lock);
+	try {
+		auto resp = jsonExchange({"binary", true}, true);
+		binary = resp[0].getBool() && resp[1].getBool();
+	} catch (std::exception &e) {
+		binary = false;
+	}
+	log.debug("Binary framing: $1", binary?"enabled":"disabled");
+}
+
+json::Value AbstractExtern::taggedExchange(json::Value request, Sync &lk) {
+	int id = msgCntr++;
+	std::future<json::Value> resp;
+	{
+		std::lock_guard<std::mutex> _(pendingLock);
+		resp = pending[id].get_future();
+	}
+	json::Value msg = {id, request[0], request[1]};
+	if (log.isLogLevelEnabled(ondra_shared::LogLevel::debug)) log.debug("SEND: $1", msg.toString().substr(0,512));
+	pid_t pid = chldid;
+	bool ok = false;
+	try {
+		ok = writeJSON(msg, extin, timeout, binary);
+	} catch (...) {
+	}
+	if (!ok) {
+		{
+			std::lock_guard<std::mutex> _(pendingLock);
+			pending.erase(id);
+		}
+		kill();
+		throw std::runtime_error("Connection to API lost");
+	}
+	//other requests can be sent while this request is waiting
+	lk.unlock();
+	if (resp.wait_for(std::chrono::milliseconds(timeout)) == std::future_status::timeout) {
+		{
+			std::lock_guard<std::mutex> _(pendingLock);
+			pending.erase(id);
+		}
+		lk.lock();
+		//don't kill the process, if it was already restarted
+		if (chldid == pid) kill();
+		report_timeout();
+	}
+	return resp.get();
+}
+
+void AbstractExtern::readerWorker() {
+	Reader rd(extout, timeout);
+	std::string errline;
+	std::string lastStdErr;
+	std::exception_ptr err;
+	bool verbose = log.isLogLevelEnabled(ondra_shared::LogLevel::debug);
+	try {
+		while (!stopReader) {
+			if (!binary) rd.skipWhitespace();
+			if (binary || !rd.hasData()) {
+				struct pollfd fds[2];
+				fds[0].fd = extout;
+				fds[0].events = POLLIN;
+				fds[0].revents = 0;
+				fds[1].fd = exterr;
+				fds[1].events = POLLIN;
+				fds[1].revents = 0;
+				//limited timeout, so the stop flag is checked periodically
+				int r = poll(fds,2,1000);
+				if (r < 0) {
+					if (errno == EINTR) continue;
+					report_error("poll");
+				}
+				if (fds[1].revents) {
+					char buff[1000];
+					int i = ::read(exterr, buff, sizeof(buff));
+					if (i < 1) {
+						throw std::runtime_error("Connection to API lost - err: "+(lastStdErr.empty()?std::string("N/A"):lastStdErr));
+					}
+					for (char c: std::string_view(buff, i)) {
+						if (c == '\n') {
+							log.note("stderr: $1", errline);
+							lastStdErr = std::move(errline);
+							errline.clear();
+						} else {
+							errline.push_back(c);
+						}
+					}
+				}
+				if (!fds[0].revents) continue;
+			}
+			json::Value resp = binary?readJSON(extout, timeout, true):json::Value::parse([&]{return rd();});
+			if (verbose) log.debug("RECV: $1", resp.toString().substr(0,512));
+			if (resp[0].type() == json::string) {
+				//asynchronous notification: ["notify", event, data]
+				if (resp[0].getString() == "notify") {
+					try {
+						onNotify(resp[1].getString(), resp[2]);
+					} catch (std::exception &e) {
+						log.error("Notification failed: $1", e.what());
+					}
+				}
+				continue;
+			}
+			if (resp[0].isNull()) {
+				//error which is not related to any request
+				log.error("Broker error: $1", resp[2].toString());
+				continue;
+			}
+			std::lock_guard<std::mutex> _(pendingLock);
+			auto iter = pending.find(resp[0].getInt());
+			//response to a request, which has already timeouted, is ignored
+			if (iter != pending.end()) {
+				json::Value result = {resp[1], resp[2]};
+				iter->second.set_value(result);
+				pending.erase(iter);
+			}
+		}
+	} catch (...) {
+		err = std::current_exception();
+	}
+	if (!err) err = std::make_exception_ptr(std::runtime_error("Connection to API closed"));
+	std::lock_guard<std::mutex> _(pendingLock);
+	for (auto &p: pending) p.second.set_exception(err);
+	pending.clear();
+	readerRunning = false;
+}
+
+void AbstractExtern::stopReaderThread() {
+	if (reader.joinable()) {
+		stopReader = true;
+		reader.join();
+		stopReader = false;
+	}
+	tagged = false;
+}
+
+void AbstractExtern::negotiateTagged() {
 	Sync _(lock);
+	try {
+		auto resp = jsonExchange({"tagged", true}, true);
+		tagged = resp[0].getBool() && resp[1].getBool();
+	} catch (std::exception &e) {
+		tagged = false;
+	}
+	if (tagged) {
+		readerRunning = true;
+		reader = std::thread([this]{readerWorker();});
+	}
+	log.debug("Tagged protocol: $1", tagged?"enabled":"disabled");
+}
+
+json::Value AbstractExtern::jsonRequestExchange(json::String name, json::Value args, bool idle) {
 	try {
 		auto resp = jsonExchange({name, args}, idle);
 		if (resp[0].getBool() == true) {
@@ -7,7 +7,11 @@
 
 #ifndef SRC_MAIN_ABSTRACTEXTERN_H_
 #define SRC_MAIN_ABSTRACTEXTERN_H_
+#include <atomic>
+#include <future>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include <imtjson/string.h>
 #include <imtjson/value.h>
@@ -23,6 +27,14 @@ public:
 
 	bool preload();
 	virtual void onConnect() {}
+	///Called when the extern process sends asynchronous notification (tagged protocol only)
+	/**
+	 * Called from the reader thread. The function must not block and must not send requests
+	 *
+	 * @param event type of the event
+	 * @param data data of the event
+	 */
+	virtual void onNotify(const std::string_view &event, const json::Value &data) {}
 	void stop();
 	void housekeeping(int counter);
 
@@ -82,13 +94,50 @@ protected:
 	void kill();
 
 	static Pipe makePipe();
+	///id of next request (tagged protocol)
 	int msgCntr = 1;
 	int houseKeepingCounter = 0;
+	///true, if binary framing is active
+	bool binary = false;
+	///true, if tagged protocol is active
+	bool tagged = false;
+
+	///requests waiting for the response (tagged protocol)
+	std::unordered_map<int, std::promise<json::Value> > pending;
+	///protects pending requests. Reader thread never holds the main lock
+	std::mutex pendingLock;
+	///thread which reads responses and dispatches them to the waiting requests
+	std::thread reader;
+	std::atomic<bool> readerRunning = false;
+	std::atomic<bool> stopReader = false;
 
 
 	json::Value jsonExchange(json::Value request, bool idle);
-	static bool writeJSON(json::Value v, FD &fd, int timeout);
-	static json::Value readJSON(FD &fd, int timeout);
+	///Negotiates binary framing with the extern process
+	/**
+	 * Should be called from onConnect(). If the extern process doesn't support
+	 * binary framing, text framing stays active
+	 */
+	void negotiateBinary();
+	///Negotiates tagged protocol with the extern process
+	/**
+	 * In tagged protocol, each request carries an id [id, command, args] and the
+	 * response carries the same id [id, ok, result]. Responses can arrive in any order,
+	 * they are read by the reader thread and dispatched to the waiting requests. The
+	 * lock is not held while the request waits for the response, so multiple requests
+	 * can be processed by the extern process at once. The extern process can also send
+	 * asynchronous notifications ["notify", event, data], which are passed to onNotify().
+	 * Error which is not related to any request has null id, it is only logged
+	 *
+	 * Should be called from onConnect() after negotiateBinary(). If the extern process
+	 * doesn't support the tagged protocol, requests are processed one by one
+	 */
+	void negotiateTagged();
+	json::Value taggedExchange(json::Value request, Sync &lk);
+	void readerWorker();
+	void stopReaderThread();
+	static bool writeJSON(json::Value v, FD &fd, int timeout, bool binary);
+	static json::Value readJSON(FD &fd, int timeout, bool binary);
 
 };
 
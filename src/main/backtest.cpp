@@ -3,7 +3,9 @@
 
 #include <cmath>
 #include "istatsvc.h"
+#include "emulator.h"
 #include "mtrader.h"
+#include "replay.h"
 #include "sgn.h"
 
 using TradeRec=IStatSvc::TradeRecord;
@@ -11,10 +13,37 @@ using Trade=IStockApi::Trade;
 using Ticker=IStockApi::Ticker;
 
 BTTrades backtest_cycle(const MTrader_Config &cfg, BTPriceSource &&priceSource, const IStockApi::MarketInfo &minfo, std::optional<double> init_pos, double balance, bool neg_bal) {
+	BTTrades trades;
+	backtest_cycle(cfg, std::move(priceSource), minfo, init_pos, balance, neg_bal,
+			[](std::size_t) {return true;},
+			[&](const BTTrade &t) {trades.push_back(t);});
+	return trades;
+}
+
+static void emitStep(const IStockApi::MarketInfo &minfo, const BTOutput &output, const BTTrade &t) {
+	if (minfo.invert_price) {
+		BTTrade x = t;
+		x.neutral_price = 1.0/x.neutral_price;
+		x.open_price = 1.0/x.open_price;
+		x.pos = -x.pos;
+		x.price.price = 1.0/x.price.price;
+		x.size = -x.size;
+		output(x);
+	} else {
+		output(t);
+	}
+}
+
+void backtest_cycle(const MTrader_Config &cfg, BTPriceSource &&priceSource, const IStockApi::MarketInfo &minfo, std::optional<double> init_pos, double balance, bool neg_bal, const BTDumpFilter &dumpState, const BTOutput &output) {
 
 	std::optional<BTPrice> price = priceSource();
-	if (!price.has_value()) return {};
-	BTTrades trades;
+	if (!price.has_value()) return;
+	std::size_t index = 0;
+
+	auto emit = [&](const BTTrade &t) {
+		emitStep(minfo, output, t);
+		index++;
+	};
 
 	Strategy s = cfg.strategy;
 
@@ -30,7 +59,8 @@ BTTrades backtest_cycle(const MTrader_Config &cfg, BTPriceSource &&priceSource,
 		if (!minfo.leverage) balance -= pos * bt.price.price;
 	}
 
-	trades.push_back(bt);
+	emit(bt);
+	double last_size = 0;
 
 	double pl = 0;
 	double minsize = std::max(minfo.min_size, cfg.min_size);
@@ -59,23 +89,15 @@ BTTrades backtest_cycle(const MTrader_Config &cfg, BTPriceSource &&priceSource,
 			Strategy::OrderData order = s.getNewOrder(minfo, p, p, dir, pos, adjbal,false);
 			bool allowAlert = (cfg.alerts || (cfg.dynmult_sliding && price->time - bt.price.time > sliding_spread_wait))
 					|| (cfg.delayed_alerts &&  price->time - bt.price.time >delayed_alert_wait);
-			if (cfg.zigzag && !trades.empty()){
-				const auto &l = trades.back();
-				if (order.size * l.size < 0 && std::abs(order.size)<std::abs(l.size)) {
-					order.size = -l.size;
+			if (cfg.zigzag){
+				if (order.size * last_size < 0 && std::abs(order.size)<std::abs(last_size)) {
+					order.size = -last_size;
 				}
 			}
 			Strategy::adjustOrder(dir, mult, allowAlert, order);
 
 			order.size  = IStockApi::MarketInfo::adjValue(order.size,minfo.asset_step,round);
-			if (cfg.max_balance.has_value()) {
-				if (pos > *cfg.max_balance) order.size = 0;
-				else if (order.size + pos > *cfg.max_balance) order.size = *cfg.max_balance - pos;
-			}
-			if (cfg.min_balance.has_value()) {
-				if (pos < *cfg.max_balance) order.size = 0;
-				else if (order.size + pos < *cfg.max_balance) order.size = *cfg.min_balance - pos;
-			}
+			order.size = MTrader::limitOrderMinMaxBalance(cfg, minfo, pos, order.size).second;
 			if (minfo.leverage) {
 				double max_lev = cfg.max_leverage?std::min(cfg.max_leverage,minfo.leverage):minfo.leverage;
 				double max_abs_pos = (adjbal * max_lev)/bt.price.price;
@@ -142,21 +164,97 @@ BTTrades backtest_cycle(const MTrader_Config &cfg, BTPriceSource &&priceSource,
 			bt.pl = pl;
 			bt.pos = pos;
 			bt.norm_profit_total = bt.norm_profit + bt.norm_accum * p;
-			bt.info = s.dumpStatePretty(minfo);
-			trades.push_back(bt);
+			if (dumpState(index)) bt.info = s.dumpStatePretty(minfo);
+			else bt.info = json::Value();
+			last_size = bt.size;
+			emit(bt);
 
 		} while (cont%16 && rep);
 	}
+}
 
-	if (minfo.invert_price) {
-		for (auto &&x: trades) {
-			x.neutral_price = 1.0/x.neutral_price;
-			x.open_price = 1.0/x.open_price;
-			x.pos = -x.pos;
-			x.price.price = 1.0/x.price.price;
-			x.size = -x.size;
-		}
+void backtest_mtrader(const MTrader_Config &cfg, BTPriceSource &&priceSource, const IStockApi::MarketInfo &minfo, std::optional<double> init_pos, double balance, bool neg_bal, const BTDumpFilter &dumpState, const BTOutput &output) {
+
+	std::optional<BTPrice> price = priceSource();
+	if (!price.has_value()) return;
+
+	double pos;
+	if (init_pos.has_value() ) {
+		pos = *init_pos;
+		if (minfo.invert_price) pos = -pos;
+	}else {
+		Strategy s = cfg.strategy;
+		pos = s.calcInitialPosition(minfo,price->price,0,balance);
+		if (!minfo.leverage) balance -= pos * price->price;
 	}
 
-	return trades;
+	auto api = std::make_shared<ReplayStockApi>(minfo, pos, balance);
+	api->setTicker(IStockApi::Ticker{price->price, price->price, price->price, price->time});
+	auto trader = Replay::createTrader(cfg, api);
+	PStockApi emul = trader->getBroker();
+	EmulatorAPI *emulator = dynamic_cast<EmulatorAPI *>(emul.get());
+	if (emulator) emulator->setNegBalance(neg_bal);
+
+	std::size_t index = 0;
+	std::size_t ntrades = 0;
+	double pl = 0;
+	double last_price = price->price;
+	BTTrade bt;
+	bt.open_price = bt.neutral_price = price->price;
+	do {
+		double p = price->price;
+		api->setTicker(IStockApi::Ticker{p,p,p,price->time});
+		trader->perform(false);
+
+		//only new records are read, the history is not copied
+		const auto &trades = trader->getTrades();
+		bt.event = BTEvent::no_event;
+		bt.size = 0;
+		for (std::size_t i = ntrades; i < trades.size(); i++) {
+			const auto &t = trades[i];
+			bt.size += t.eff_size;
+			if (t.size == 0 && t.id.getString().startsWith("LOSS:")) bt.event = BTEvent::accept_loss;
+			bt.norm_profit = t.norm_profit;
+			bt.norm_accum = t.norm_accum;
+			bt.neutral_price = t.neutral_price;
+			bt.open_price = t.price;
+		}
+		ntrades = trades.size();
+
+		pl += pos * (p - last_price);
+		pos = emul->getBalance(minfo.asset_symbol, cfg.pairsymb);
+		last_price = p;
+		if (!minfo.leverage && bt.event == BTEvent::no_event
+				&& (pos < 0 || emul->getBalance(minfo.currency_symbol, cfg.pairsymb) < 0)) {
+			bt.event = BTEvent::no_balance;
+		}
+
+		bt.price = *price;
+		bt.pl = pl;
+		bt.pos = pos;
+		bt.norm_profit_total = bt.norm_profit + bt.norm_accum * p;
+		if (dumpState(index)) bt.info = trader->getStrategy().dumpStatePretty(minfo);
+		else bt.info = json::Value();
+		emitStep(minfo, output, bt);
+		index++;
+		price = priceSource();
+	} while (price.has_value());
+}
+
+void BTSummary::add(const BTTrade &t) {
+	steps++;
+	if (t.size) trades++;
+	switch (t.event) {
+	default: break;
+	case BTEvent::margin_call: margin_calls++;break;
+	case BTEvent::liquidation: liquidations++;break;
+	case BTEvent::no_balance: no_balance++;break;
+	case BTEvent::accept_loss: accept_loss++;break;
+	}
+	norm_profit = t.norm_profit;
+	norm_profit_total = t.norm_profit_total;
+	pl = t.pl;
+	pos = t.pos;
+	max_pl = std::max(max_pl, pl);
+	max_drawdown = std::max(max_drawdown, max_pl - pl);
 }
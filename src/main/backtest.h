@@ -46,11 +46,67 @@ struct BTTrade {
 using BTPriceSource = std::function<std::optional<BTPrice>()>;
 using BTTrades = std::vector<BTTrade>;
 
+///Summary of the backtest - without per-step data
+struct BTSummary {
+	///final normalized profit
+	double norm_profit = 0;
+	///final normalized profit including accumulation
+	double norm_profit_total = 0;
+	///final profit/loss
+	double pl = 0;
+	///final position
+	double pos = 0;
+	///maximum drawdown of the profit/loss
+	double max_drawdown = 0;
+	///highest profit/loss reached (used to calculate drawdown)
+	double max_pl = 0;
+	///count of steps
+	std::size_t steps = 0;
+	///count of executed trades
+	std::size_t trades = 0;
+	std::size_t margin_calls = 0;
+	std::size_t liquidations = 0;
+	std::size_t no_balance = 0;
+	std::size_t accept_loss = 0;
+
+	///Updates summary by next step of the backtest
+	void add(const BTTrade &t);
+};
+
 class IStockSelector;
 
 
+///Receives steps of the backtest
+using BTOutput = std::function<void(const BTTrade &)>;
+///Decides whether the state of the strategy is dumped into BTTrade::info for given step (index)
+using BTDumpFilter = std::function<bool(std::size_t)>;
+
+///Runs backtest and returns all steps including strategy state dumps
 BTTrades backtest_cycle(const MTrader_Config &config, BTPriceSource &&priceSource, const IStockApi::MarketInfo &minfo, std::optional<double> init_pos, double balance, bool negbal);
 
+///Runs backtest and sends each step to the output
+/**
+ * Steps are not collected. The strategy state is dumped only for steps selected
+ * by the dumpState filter
+ */
+void backtest_cycle(const MTrader_Config &config, BTPriceSource &&priceSource, const IStockApi::MarketInfo &minfo, std::optional<double> init_pos, double balance, bool negbal, const BTDumpFilter &dumpState, const BTOutput &output);
+
+///Runs backtest using the MTrader against simulated broker and clock
+/**
+ * Unlike backtest_cycle(), orders are calculated by the same code as in the live
+ * trading (including dynmult, alerts, zigzag, accept loss and all limits). Each price
+ * is one cycle of the trader. Events margin_call and liquidation are not reported,
+ * because the trader doesn't place such orders. If negbal is false, orders exceeding
+ * the balance are not executed, otherwise they are executed and no_balance is reported
+ *
+ * The engine is much slower than backtest_cycle(), so it is not the default engine.
+ * The backtest_cycle() still keeps its own simplified order logic, separated from
+ * MTrader, so both engines can give different results for the same config
+ *
+ * Arguments and output are same as for backtest_cycle()
+ */
+void backtest_mtrader(const MTrader_Config &config, BTPriceSource &&priceSource, const IStockApi::MarketInfo &minfo, std::optional<double> init_pos, double balance, bool negbal, const BTDumpFilter &dumpState, const BTOutput &output);
+
 
 
 #endif /* SRC_MAIN_BACKTEST_H_ */
@@ -0,0 +1,316 @@
+/*
+ * bench.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <experimental/filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+#include <imtjson/value.h>
+#include "../pricegen/price_generator.h"
+#include "backtest.h"
+#include "mtrader.h"
+#include "report.h"
+#include "rolling_spread.h"
+#include "storage.h"
+#include "strategy.h"
+
+using json::Object;
+using json::Value;
+using namespace std::experimental::filesystem;
+
+///Microbenchmarks of the strategies, backtest, spread calculation, report and storage
+/**
+ * Each benchmark prints one line of JSON to the stdout:
+ *
+ * {"name":..., "runs":..., "ops":..., "ns_per_op":..., "ms":...}
+ *
+ * The benchmark is repeated (doubling runs) until it takes at least given time. All
+ * data are generated with fixed seeds, so the results are comparable between builds.
+ *
+ * Usage: mmbot_bench [-t min_ms] [-d backtest_dir] [filter]
+ */
+
+static unsigned int min_time_ms = 200;
+static std::string filter;
+static volatile double sink;
+
+///Runs the benchmark
+/**
+ * @param name name of the benchmark
+ * @param fn function, which performs one run and returns count of operations
+ */
+template<typename Fn>
+static void bench(const std::string &name, Fn &&fn) {
+	if (!filter.empty() && name.find(filter) == name.npos) return;
+	using clock = std::chrono::steady_clock;
+	std::size_t runs = 1;
+	std::size_t ops;
+	double ns;
+	while (true) {
+		ops = 0;
+		auto start = clock::now();
+		for (std::size_t i = 0; i < runs; i++) ops += fn();
+		ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+		if (ns >= min_time_ms * 1e6 || runs >= (std::size_t(1)<<30)) break;
+		runs *= 2;
+	}
+	std::cout << Value(Object("name", name)
+			("runs", runs)
+			("ops", ops)
+			("ns_per_op", ops?ns/ops:0.0)
+			("ms", ns*1e-6)).stringify() << std::endl;
+}
+
+static IStockApi::MarketInfo benchMarket(double leverage) {
+	IStockApi::MarketInfo minfo;
+	minfo.asset_symbol = "BTC";
+	minfo.currency_symbol = "USD";
+	minfo.asset_step = 0;
+	minfo.currency_step = 0;
+	minfo.min_size = 0;
+	minfo.min_volume = 0;
+	minfo.fees = 0;
+	minfo.leverage = leverage;
+	minfo.invert_price = false;
+	minfo.simulator = true;
+	return minfo;
+}
+
+static std::vector<double> benchPrices(std::size_t count, double price = 10000) {
+	return GBMGenerator(0, 0.8).generate(price, count, 1, IPriceGenerator::minutes_per_year);
+}
+
+static Value strategyConfig(const std::string &id) {
+	Value cfg = Object("type", id)
+			("ea", 0)
+			("accum", 0)
+			("valinc", 0)
+			("power", 1)
+			("max_loss", 0)
+			("asym", 0)
+			("reduction", 0)
+			("curv", 5)
+			("reduction_steps", 2)
+			("max_steps", 20)
+			("pattern", "constant")
+			("mode", "auto")
+			("redmode", "stepsBack");
+	return cfg;
+}
+
+static void benchStrategies() {
+	static const char *ids[] = {
+			"halfhalf","keepvalue","exponencial","hypersquare","conststep","errorfn",
+			"stairs","hyperbolic","linear","sinh","sinh2","sinh_val"
+	};
+	const std::size_t count = 10000;
+	auto prices = benchPrices(count);
+	for (bool lev: {false, true}) {
+		IStockApi::MarketInfo minfo = benchMarket(lev?10:0);
+		std::string suffix = lev?"/leveraged":"";
+		for (const char *id: ids) {
+			Strategy init = Strategy::create(id, strategyConfig(id));
+			double price = prices[0];
+			double currency = 10000;
+			double assets = init.calcInitialPosition(minfo, price, 0, currency);
+			if (!lev) currency -= assets * price;
+			IStockApi::Ticker tk{price, price, price, 0};
+			init.onIdle(minfo, tk, assets, currency);
+			if (!init.isValid()) continue;
+
+			std::string name = std::string("strategy/")+id+suffix;
+			bench(name + "/getNewOrder", [&]{
+				for (std::size_t i = 1; i < count; i++) {
+					double p = prices[i];
+					auto order = init.getNewOrder(minfo, p, p, p > price?-1:1, assets, currency, false);
+					sink = order.size;
+				}
+				return count-1;
+			});
+			bench(name + "/onTrade", [&]{
+				Strategy s = init;
+				double a = assets;
+				double c = currency;
+				double last = price;
+				for (std::size_t i = 1; i < count; i++) {
+					double p = prices[i];
+					IStockApi::Ticker tk{p, p, p, i*60000};
+					s.onIdle(minfo, tk, a, c);
+					auto order = s.getNewOrder(minfo, p, p, p > last?-1:1, a, c, false);
+					double sz = order.size;
+					if (!lev) {
+						if (c - sz * p < 0 || a + sz < 0) sz = 0;
+						c -= sz * p;
+					} else {
+						c += a * (p - last);
+					}
+					a += sz;
+					auto res = s.onTrade(minfo, p, sz, a, c);
+					sink = res.normProfit;
+					last = p;
+				}
+				return count-1;
+			});
+		}
+	}
+}
+
+static BTPriceSource seriesSource(const PriceSeries &s) {
+	return [&s, i = std::size_t(0)]() mutable -> std::optional<BTPrice> {
+		if (i >= s.prices.size()) return {};
+		BTPrice p{s.start_time + i * s.interval, s.prices[i]};
+		i++;
+		return p;
+	};
+}
+
+static void benchBacktest(const std::string &dir) {
+	MTrader_Config cfg;
+	cfg.loadConfig(Object("pair_symbol","BTCUSD")
+			("strategy", strategyConfig("hyperbolic")), false);
+	IStockApi::MarketInfo minfo = benchMarket(0);
+	std::error_code ec;
+	std::vector<path> files;
+	for (const auto &entry: directory_iterator(dir, ec)) {
+		if (entry.path().extension() == ".csv") files.push_back(entry.path());
+	}
+	std::sort(files.begin(), files.end());
+	for (const auto &f: files) {
+		PriceSeries s = PriceSeries::loadCSVFile(f.string());
+		if (s.prices.empty()) continue;
+		double balance = 1000 * s.prices[0];
+		bench("backtest/"+f.stem().string(), [&]{
+			double pl = 0;
+			backtest_cycle(cfg, seriesSource(s), minfo, std::optional<double>(), balance, false,
+					[](std::size_t) {return false;}, [&](const BTTrade &t) {pl = t.pl;});
+			sink = pl;
+			return s.prices.size();
+		});
+	}
+}
+
+static void benchSpread() {
+	const std::size_t hours = 240;
+	auto prices = benchPrices(hours * 60);
+	bench("spread/visualizeSpread/240h", [&]{
+		std::size_t i = 0;
+		auto res = MTrader::visualizeSpread([&]() -> std::optional<MTrader::ChartItem> {
+			if (i >= prices.size()) return {};
+			double p = prices[i];
+			return MTrader::ChartItem{60000*i++, p, p, p};
+		}, 24, 4, 1, 1, 1, "independent", false, false, true, false);
+		sink = res.chart.size();
+		return prices.size();
+	});
+	bench("spread/rolling/240h", [&]{
+		RollingSpread spread(24*60, 4*60);
+		for (double p: prices) spread.push(p);
+		sink = spread.getSpread();
+		return prices.size();
+	});
+}
+
+class NullStorage: public IStorage {
+public:
+	virtual void store(json::Value ) override {}
+	virtual json::Value load() override {return json::Value();}
+	virtual void erase() override {}
+};
+
+static void benchReport() {
+	const std::size_t trades = 1000;
+	auto prices = benchPrices(trades + 1);
+	for (std::size_t ntraders: {1, 10, 50}) {
+		Report rpt(std::make_unique<NullStorage>(), 60000);
+		std::vector<std::string> names;
+		std::vector<std::vector<IStatSvc::TradeRecord> > records(ntraders);
+		for (std::size_t t = 0; t < ntraders; t++) {
+			names.push_back("trader_"+std::to_string(t));
+			rpt.setInfo(names[t], IStatSvc::Info{names[t], "BTC", "USD", "USD", "", 0, static_cast<double>(t), false, false, true});
+			auto &recs = records[t];
+			recs.reserve(trades+1);
+			for (std::size_t i = 0; i < trades; i++) {
+				double sz = (i & 1)?0.1:-0.1;
+				recs.emplace_back(IStockApi::Trade{Value(i), i*600000, sz, prices[i], sz, prices[i]}, 0, 0, prices[i]);
+			}
+			rpt.setTrades(names[t], recs);
+		}
+		rpt.genReport();
+		bench("report/genReport/"+std::to_string(ntraders), [&]{
+			//each cycle, every trader reports price and one trade is replaced
+			for (std::size_t t = 0; t < ntraders; t++) {
+				auto &recs = records[t];
+				recs.back().price = prices[trades];
+				rpt.setPrice(names[t], prices[trades]);
+				rpt.setTrades(names[t], recs);
+			}
+			rpt.genReport();
+			return ntraders;
+		});
+	}
+}
+
+static void benchStorage() {
+	const std::size_t trades = 20000;
+	auto prices = benchPrices(trades);
+	json::Array chart, trd;
+	for (std::size_t i = 0; i < trades; i++) {
+		chart.push_back(Object("time", i*60000)("ask", prices[i])("bid", prices[i])("last", prices[i]));
+		trd.push_back(Object("id", i)("time", i*60000)("size", 0.1)("price", prices[i])
+				("eff_size", 0.1)("eff_price", prices[i])("np", 0)("ap", 0)("p0", prices[i]));
+	}
+	Value state = Object("chart", chart)("trades", trd)("internal_balance", 1)("currency_balance", 10000);
+
+	path dir = temp_directory_path() / ("mmbot_bench_"+std::to_string(::getpid()));
+	create_directories(dir);
+	struct {const char *name; Storage::Format fmt;} formats[] = {
+			{"json", Storage::json}, {"binjson", Storage::binjson}
+	};
+	for (const auto &f: formats) {
+		Storage stor((dir / f.name).string(), 1, f.fmt);
+		bench(std::string("storage/store/")+f.name, [&]{
+			stor.store(state);
+			return std::size_t(1);
+		});
+		bench(std::string("storage/load/")+f.name, [&]{
+			sink = stor.load()["trades"].size();
+			return std::size_t(1);
+		});
+	}
+	std::error_code ec;
+	remove_all(dir, ec);
+}
+
+int main(int argc, char **argv) {
+	std::string bt_dir = "backtest";
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-t" && i+1 < argc) min_time_ms = std::strtoul(argv[++i], nullptr, 10);
+		else if (arg == "-d" && i+1 < argc) bt_dir = argv[++i];
+		else filter = arg;
+	}
+	try {
+		benchStrategies();
+		benchBacktest(bt_dir);
+		benchSpread();
+		benchReport();
+		benchStorage();
+		return 0;
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+}
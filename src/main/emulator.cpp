@@ -171,6 +171,9 @@ void EmulatorAPI::simulation(const Ticker &tk) {
 		double sm = diffp * o.size;
 		if (sm > 0) {
 			left_orders.push_back(std::move(o));
+		} else if (!margin && !neg_bal && (currency < o.size * o.price || balance + o.size < 0)) {
+			//not enough balance - order is removed
+			ondra_shared::logDebug("Emulator: not enough balance for $1 on $2", o.size, o.price);
 		} else {
 			auto tm = tk.time;
 
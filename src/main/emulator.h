@@ -39,6 +39,13 @@ public:
 	//retrieves name of saved image
 	virtual std::string getIconName() const override;
 
+	///Enables or disables negative balances (default enabled)
+	/**
+	 * When disabled, orders on spot market which would make any balance negative
+	 * are not executed (they are removed as the exchange would reject them)
+	 */
+	void setNegBalance(bool enable) {neg_bal = enable;}
+
 	static std::string_view prefix;
 
 protected:
@@ -61,6 +68,7 @@ protected:
 	bool initial_read_balance = true;
 	bool initial_read_currency = true;
 	bool margin = false;
+	bool neg_bal = true;
 
 	double readBalance(const std::string_view &symb, const std::string_view & pair, double defval);
 
@@ -12,6 +12,7 @@
 
 #include <imtjson/object.h>
 #include <imtjson/binary.h>
+#include <algorithm>
 #include <fstream>
 #include <set>
 
@@ -26,18 +27,24 @@ ExtStockApi::ExtStockApi(const std::string_view & workingDir, const std::string_
 
 
 
+json::Value ExtStockApi::balanceArgs(const std::string_view & symb, const std::string_view & pair) {
+	return json::Object("pair", pair)
+				  ("symbol", symb);
+}
+
+json::Value ExtStockApi::syncTradesArgs(json::Value lastId, const std::string_view & pair) {
+	return json::Object("lastId",lastId)
+			("pair",StrViewA(pair));
+}
+
 double ExtStockApi::getBalance(const std::string_view & symb, const std::string_view & pair) {
-	return requestExchange("getBalance",
-			json::Object("pair", pair)
-				  ("symbol", symb)).getNumber();
+	return requestExchange("getBalance", balanceArgs(symb, pair)).getNumber();
 
 }
 
 
 ExtStockApi::TradesSync ExtStockApi::syncTrades(json::Value lastId, const std::string_view & pair) {
-	auto r = requestExchange("syncTrades",json::Object
-			("lastId",lastId)
-			("pair",StrViewA(pair)));
+	auto r = requestExchange("syncTrades",syncTradesArgs(lastId, pair));
 	TradeHistory  th;
 	for (json::Value v: r["trades"]) th.push_back(Trade::fromJSON(v));
 	return TradesSync {
@@ -86,7 +93,11 @@ json::Value  ExtStockApi::placeOrder(const std::string_view & pair,
 
 
 bool ExtStockApi::reset() {
-	std::unique_lock _(connection->getLock());
+	{
+		std::unique_lock _(connection->getLock());
+		prefetched.clear();
+		snapshot_taken = false;
+	}
 	//save housekeep counter to avoid reset treat as action
 	if (connection->isActive()) try {
 		requestExchange("reset",json::Value(),true);
@@ -135,14 +146,29 @@ std::vector<std::string> ExtStockApi::getAllPairs() {
 void ExtStockApi::Connection::onConnect() {
 	ondra_shared::LogObject lg("");
 	bool debug= lg.isLogLevelEnabled(ondra_shared::LogLevel::debug);
+	negotiateBinary();
+	negotiateTagged();
 	try {
 		jsonRequestExchange("enableDebug",debug, false);
 	} catch (AbstractExtern::Exception &) {
 
 	}
+	//new instance of the broker can support batches, even if the previous one failed
+	batch_supported = true;
+	snapshot_supported = true;
 	instance_counter++;
 }
 
+void ExtStockApi::Connection::onNotify(const std::string_view &event, const json::Value &data) {
+	std::lock_guard<std::mutex> _(notifyLock);
+	if (notifyCb) notifyCb(event, data.getString());
+}
+
+void ExtStockApi::Connection::setNotifyCallback(IBrokerNotify::Callback &&cb) {
+	std::lock_guard<std::mutex> _(notifyLock);
+	notifyCb = std::move(cb);
+}
+
 ExtStockApi::BrokerInfo ExtStockApi::getBrokerInfo()  {
 
 	try {
@@ -250,6 +276,8 @@ ExtStockApi::PageData ExtStockApi::fetchPage(const std::string_view &method,
 }
 
 json::Value ExtStockApi::requestExchange(json::String name, json::Value args, bool idle) {
+	json::Value pf;
+	if (IBrokerBatch::Consumer::isActive() && takePrefetched(name, args, pf)) return pf;
 	if (connection->wasRestarted(instance_counter)) {
 		if (broker_config.defined()) {
 			if (subaccount.empty()) connection->jsonRequestExchange("restoreSettings", broker_config, idle);
@@ -298,3 +326,127 @@ ExtStockApi *ExtStockApi::createSubaccount(const std::string &subaccount) const
 	ExtStockApi *copy = new ExtStockApi(connection,subaccount);
 	return copy;
 }
+
+void ExtStockApi::setNotifyCallback(IBrokerNotify::Callback &&cb) {
+	connection->setNotifyCallback(std::move(cb));
+}
+
+void ExtStockApi::marketStatusRequests(const std::string_view &pair, json::Value lastId,
+		const std::string_view &asset, const std::string_view &currency, bool balances,
+		RequestList &reqs) {
+	//order of requests is same as order of requests of the trader
+	reqs.emplace_back("getOpenOrders", StrViewA(pair));
+	reqs.emplace_back("syncTrades", syncTradesArgs(lastId, pair));
+	if (balances) {
+		reqs.emplace_back("getBalance", balanceArgs(asset, pair));
+		reqs.emplace_back("getBalance", balanceArgs(currency, pair));
+	}
+	reqs.emplace_back("getFees", pair);
+	reqs.emplace_back("getTicker", StrViewA(pair));
+}
+
+void ExtStockApi::prefetchMarketStatus(const std::string_view &pair, json::Value lastId,
+		const std::string_view &asset, const std::string_view &currency, bool balances) {
+	RequestList reqs;
+	marketStatusRequests(pair, lastId, asset, currency, balances, reqs);
+	prefetch(std::move(reqs));
+}
+
+void ExtStockApi::snapshotMarkets(const std::vector<IBrokerSnapshot::Request> &reqs) {
+	RequestList lst;
+	json::Array pairs;
+	for (auto &&r: reqs) {
+		marketStatusRequests(r.pair, r.lastId, r.asset, r.currency, r.balances, lst);
+		pairs.push_back(r.pair);
+	}
+	prefetch(std::move(lst), pairs);
+}
+
+///Returns true, if the broker rejected the command because it doesn't know it
+static bool isUnknownCommand(const AbstractExtern::Exception &e) {
+	return e.getMsg() == "Method not implemented";
+}
+
+void ExtStockApi::prefetch(RequestList &&reqs, json::Value pairs) {
+	{
+		std::unique_lock _(connection->getLock());
+		if (pairs.defined() || !snapshot_taken) {
+			prefetched.clear();
+			snapshot_taken = false;
+		} else {
+			//requests already prefetched by the snapshot are not fetched again
+			std::vector<bool> used(prefetched.size(), false);
+			reqs.erase(std::remove_if(reqs.begin(), reqs.end(), [&](const auto &r) {
+				for (std::size_t i = 0; i < prefetched.size(); i++) {
+					const Prefetched &p = prefetched[i];
+					if (!used[i] && p.name == r.first && p.args == r.second) {
+						used[i] = true;
+						return true;
+					}
+				}
+				return false;
+			}), reqs.end());
+		}
+	}
+	if (reqs.empty() || !connection->batch_supported) return;
+
+	json::Array batch;
+	batch.reserve(reqs.size());
+	for (auto &&r: reqs) batch.push_back({r.first, r.second});
+
+	//unknown command is not used until the broker is reconnected (see onConnect)
+	json::Value resp;
+	if (pairs.defined() && connection->snapshot_supported) try {
+		resp = requestExchange("getMarketSnapshot", json::Object("pairs", pairs)("requests", batch));
+	} catch (const AbstractExtern::Exception &e) {
+		if (isUnknownCommand(e)) {
+			connection->snapshot_supported = false;
+			logNote("Broker $1 - market snapshot is disabled: $2", connection->getName(), e.what());
+		} else {
+			//other errors are transient, the batch is used in this cycle only
+			logWarning("Broker $1 - market snapshot failed: $2", connection->getName(), e.what());
+		}
+	} catch (const std::exception &e) {
+		logWarning("Broker $1 - market snapshot failed: $2", connection->getName(), e.what());
+	}
+	//if the batch fails, requests will be processed one by one
+	if (!resp.defined()) try {
+		resp = requestExchange("batch", batch);
+	} catch (const AbstractExtern::Exception &e) {
+		if (isUnknownCommand(e)) {
+			connection->batch_supported = false;
+			logNote("Broker $1 - batches are disabled: $2", connection->getName(), e.what());
+		} else {
+			logWarning("Broker $1 - batch failed: $2", connection->getName(), e.what());
+		}
+		return;
+	} catch (const std::exception &e) {
+		logWarning("Broker $1 - batch failed: $2", connection->getName(), e.what());
+		return;
+	}
+
+	//lock is not held during the request, so other traders can use the connection
+	std::unique_lock _(connection->getLock());
+	if (pairs.defined()) snapshot_taken = true;
+	for (std::size_t i = 0, cnt = std::min<std::size_t>(resp.size(), reqs.size()); i < cnt; i++) {
+		json::Value r = resp[i];
+		prefetched.push_back(Prefetched{reqs[i].first, reqs[i].second, r[0].getBool(), r[1]});
+	}
+}
+
+bool ExtStockApi::takePrefetched(const json::String &name, const json::Value &args, json::Value &result) {
+	std::unique_lock _(connection->getLock());
+	auto iter = std::find_if(prefetched.begin(), prefetched.end(), [&](const Prefetched &p) {
+		return p.name == name && p.args == args;
+	});
+	if (iter == prefetched.end()) return false;
+	Prefetched p = std::move(*iter);
+	prefetched.erase(iter);
+	if (p.ok) {
+		result = p.result;
+		return true;
+	}
+	std::string accname = connection->getName();
+	if (!subaccount.empty()) accname = accname + "~" + subaccount;
+	throw AbstractExtern::Exception(std::string(p.result.toString().c_str()), accname, name.c_str());
+}
@@ -15,7 +15,7 @@
 
 
 
-class ExtStockApi: public IStockApi, public IApiKey, public IBrokerControl, public IBrokerIcon, public IBrokerSubaccounts {
+class ExtStockApi: public IStockApi, public IApiKey, public IBrokerControl, public IBrokerIcon, public IBrokerSubaccounts, public IBrokerBatch, public IBrokerSnapshot, public IBrokerNotify {
 public:
 
 	ExtStockApi(const std::string_view & workingDir, const std::string_view & name, const std::string_view & cmdline, int timeout);
@@ -49,6 +49,11 @@ public:
 	virtual ExtStockApi *createSubaccount(const std::string &subaccount) const override;
 	virtual bool isSubaccount() const override;
 	virtual json::Value getMarkets() const override;
+	virtual void prefetchMarketStatus(const std::string_view &pair, json::Value lastId,
+			const std::string_view &asset, const std::string_view &currency, bool balances) override;
+	virtual void snapshotMarkets(const std::vector<IBrokerSnapshot::Request> &reqs) override;
+	///Sets callback of notifications (subaccounts share the callback with the main account)
+	virtual void setNotifyCallback(IBrokerNotify::Callback &&cb) override;
 
 
 protected:
@@ -56,20 +61,65 @@ protected:
 	public:
 		using AbstractExtern::AbstractExtern;
 		virtual void onConnect() override;
+		virtual void onNotify(const std::string_view &event, const json::Value &data) override;
+		void setNotifyCallback(IBrokerNotify::Callback &&cb);
 		bool wasRestarted(int &counter);
 		const std::string &getName() const {return this->name;}
 		std::recursive_mutex &getLock() const {return lock;}
 		bool isActive() const {return this->chldid != -1;}
+		///false if the broker doesn't support command "batch"
+		std::atomic<bool> batch_supported = true;
+		///false if the broker doesn't support command "getMarketSnapshot"
+		std::atomic<bool> snapshot_supported = true;
 	protected:
 		std::atomic<int> instance_counter = 0;
+		std::mutex notifyLock;
+		IBrokerNotify::Callback notifyCb;
+	};
+
+	struct Prefetched {
+		json::String name;
+		json::Value args;
+		bool ok;
+		json::Value result;
 	};
 
 	json::Value broker_config;
+	std::vector<Prefetched> prefetched;
+	///true, if prefetched contains the market snapshot (valid until reset)
+	bool snapshot_taken = false;
 	std::shared_ptr<Connection> connection;
 	int instance_counter = 0;
 	std::string subaccount;
 
+	using RequestList = std::vector<std::pair<json::String, json::Value> >;
+
 	ExtStockApi(std::shared_ptr<Connection> connection, const std::string &subaccid);
+
+	///Executes requests in one exchange, results are stored for next requests
+	/**
+	 * @param reqs requests. Requests which are already prefetched are skipped
+	 * @param pairs list of pairs, if defined, requests are sent as market snapshot
+	 * (getMarketSnapshot) which allows to broker to fetch data of all pairs at once.
+	 * Otherwise, requests are sent as batch
+	 */
+	void prefetch(RequestList &&reqs, json::Value pairs = json::Value());
+	///Appends requests needed to retrieve market status
+	static void marketStatusRequests(const std::string_view &pair, json::Value lastId,
+			const std::string_view &asset, const std::string_view &currency, bool balances,
+			RequestList &reqs);
+	///Retrieves prefetched result of the request
+	/**
+	 * @param name name of the request
+	 * @param args arguments
+	 * @param result result
+	 * @retval true result found (and removed)
+	 * @retval false not found
+	 * @exception AbstractExtern::Exception prefetched request failed
+	 */
+	bool takePrefetched(const json::String &name, const json::Value &args, json::Value &result);
+	static json::Value balanceArgs(const std::string_view & symb, const std::string_view & pair);
+	static json::Value syncTradesArgs(json::Value lastId, const std::string_view & pair);
 };
 
 
@@ -7,6 +7,7 @@
 
 #ifndef SRC_MAIN_IBROKERCONTROL_H_
 #define SRC_MAIN_IBROKERCONTROL_H_
+#include <functional>
 #include <imtjson/value.h>
 
 class IBrokerControl {
@@ -55,6 +56,93 @@ public:
 
 class IStockApi;
 
+///Broker is able to execute multiple requests in one exchange
+class IBrokerBatch {
+public:
+	///Fetches everything needed to retrieve market status in one exchange
+	/**
+	 * Results are returned by following calls of getOpenOrders, syncTrades, getBalance, getFees
+	 * and getTicker with the same arguments (each result is returned once), if they are made
+	 * in the scope of the Consumer. Results which are not used are dropped by next prefetch
+	 * or reset. If the broker doesn't support batches, the function does nothing
+	 *
+	 * @param pair trading pair
+	 * @param lastId argument of syncTrades
+	 * @param asset asset symbol (for getBalance)
+	 * @param currency currency symbol (for getBalance)
+	 * @param balances set true to fetch balances
+	 */
+	virtual void prefetchMarketStatus(const std::string_view &pair, json::Value lastId,
+			const std::string_view &asset, const std::string_view &currency, bool balances) = 0;
+	virtual ~IBrokerBatch() {}
+
+	///Allows the current thread to use prefetched results while the object exists
+	/**
+	 * The trader creates this object while it reads the market status. Other requests
+	 * (admin, UI) are always sent to the broker, so they never take results prepared
+	 * for the trader. Prefetched results of the snapshot are used the same way.
+	 */
+	class Consumer {
+	public:
+		Consumer():prev(active) {active = true;}
+		Consumer(const Consumer &) = delete;
+		Consumer &operator=(const Consumer &) = delete;
+		~Consumer() {release();}
+		///Stops use of prefetched results before the object is destroyed
+		void release() {
+			if (!released) {active = prev; released = true;}
+		}
+		///Returns true, if the current thread can use prefetched results
+		static bool isActive() {return active;}
+	protected:
+		bool prev;
+		bool released = false;
+		static inline thread_local bool active = false;
+	};
+};
+
+///Broker is able to fetch status of all markets at the beginning of the cycle
+class IBrokerSnapshot {
+public:
+	///Request for status of one market (same arguments as IBrokerBatch::prefetchMarketStatus)
+	struct Request {
+		std::string pair;
+		json::Value lastId;
+		std::string asset;
+		std::string currency;
+		bool balances;
+	};
+	///Fetches status of all given markets in one exchange
+	/**
+	 * Results are returned by following calls of getOpenOrders, syncTrades, getBalance, getFees
+	 * and getTicker with the same arguments (each result is returned once). Results which
+	 * are not used are dropped by reset. The broker can fetch data of all markets by
+	 * bulk requests, so the cost doesn't grow with count of traders
+	 *
+	 * @param reqs list of requests, one per trader
+	 */
+	virtual void snapshotMarkets(const std::vector<Request> &reqs) = 0;
+	virtual ~IBrokerSnapshot() {}
+};
+
+///Broker is able to send asynchronous notifications
+class IBrokerNotify {
+public:
+	///Notification callback
+	/**
+	 * @param event type of the event - "fill" order has been executed (even partially),
+	 * "price" price has been changed
+	 * @param pair affected pair
+	 *
+	 * @note The callback is called from the broker's thread. It must not block and it must
+	 * not call the broker
+	 */
+	using Callback = std::function<void(const std::string_view &event, const std::string_view &pair)>;
+	///Sets callback (replaces previous one). Empty callback disables notifications
+	virtual void setNotifyCallback(Callback &&cb) = 0;
+	virtual ~IBrokerNotify() {}
+};
+
 class IBrokerSubaccounts {
 public:
 	virtual IStockApi *createSubaccount(const std::string &subaccount) const= 0;
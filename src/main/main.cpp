@@ -3,6 +3,8 @@
 #include <shared/stdLogFile.h>
 #include <shared/default_app.h>
 #include <algorithm>
+#include <atomic>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -11,6 +13,7 @@
 #include "../server/src/simpleServer/http_filemapper.h"
 #include "../server/src/simpleServer/http_pathmapper.h"
 #include "../server/src/simpleServer/http_server.h"
+#include "../server/src/simpleServer/query_parser.h"
 #include "../shared/linux_crash_handler.h"
 
 #include "shared/ini_config.h"
@@ -33,10 +36,14 @@
 #include "../server/src/simpleServer/http_hostmapping.h"
 #include "../server/src/simpleServer/threadPoolAsync.h"
 #include "ext_storage.h"
+#include "record_storage.h"
+#include "replay.h"
 #include "extdailyperfmod.h"
 #include "localdailyperfmod.h"
 #include "stats2report.h"
 #include "traders.h"
+#include "trader_executor.h"
+#include "trader_wakeup.h"
 
 using ondra_shared::StdLogFile;
 using ondra_shared::StrViewA;
@@ -64,6 +71,36 @@ static ondra_shared::CrashHandler report_crash([](const char *line) {
 	ondra_shared::logFatal("CrashReport: $1", line);
 });
 
+///Handles /api/report - returns changes of the report since the revision known by the client
+/**
+ * Query: since=<rev> - revision known by the client (0 or missing - whole report),
+ * wait=1 - long poll, response is sent after next report is generated
+ */
+static bool reportFeed(PReport rpt, simpleServer::HTTPRequest req, const StrViewA &vpath) {
+	simpleServer::QueryParser qp(vpath);
+	if (qp.getPath() != "/report") return false;
+	if (!req.allowMethods({"GET"})) return true;
+	std::size_t since = 0;
+	bool wait = false;
+	for (auto &&v: qp) {
+		if (v.first == "since") {
+			since = std::strtoull(std::string(v.second.data, v.second.length).c_str(), nullptr, 10);
+		} else if (v.first == "wait") {
+			wait = v.second == "1" || v.second == "true";
+		}
+	}
+	auto send = [req](json::Value delta) mutable {
+		req.sendResponse("application/json", delta.stringify());
+	};
+	if (wait) {
+		auto delta = rpt.lock()->waitForDelta(since, Report::DeltaCallback(send));
+		if (delta.has_value()) send(std::move(*delta));
+	} else {
+		send(rpt.lock_shared()->getDelta(since));
+	}
+	return true;
+}
+
 
 class App: public ondra_shared::DefaultApp {
 public:
@@ -99,6 +136,7 @@ public:
 				"reset        - erases all trades expect the last one",
 				"repair       - repair pair",
 				"admin        - generate temporary admin login and password",
+				"replay       - replay recorded prices on trader's configuration. Need id of trader, optionally price file (or - for trader's chart), assets and currency",
 		};
 
 		const char *intro[] = {
@@ -170,9 +208,16 @@ int main(int argc, char **argv) {
 						auto storageBinary = servicesection["storage_binary"].getBool(true);
 						auto storageBroker = servicesection["storage_broker"];
 						auto storageVersions = servicesection["storage_versions"].getUInt(5);
+						auto storageRecords = servicesection["storage_records"].getBool(false);
 						auto listen = servicesection["listen"].getString();
 						auto socket = servicesection["socket"].getPath();
 						auto brk_timeout = servicesection["broker_timeout"].getInt(10000);
+						auto trader_threads = servicesection["trader_threads"].getUInt(0);
+						auto broker_concurrency = servicesection["broker_concurrency"].getUInt(1);
+						auto backtest_cache_size = servicesection["backtest_cache_size"].getUInt(8);
+						auto backtest_cache_spill = servicesection["backtest_cache_spill"].getPath();
+						auto wakeup_events_str = servicesection["wakeup_events"].getString();
+						auto wakeup_debounce = servicesection["wakeup_debounce"].getUInt(500);
 						auto rptsect = app.config["report"];
 						auto rptpath = rptsect.mandatory["path"].getPath();
 						auto rptinterval = rptsect["interval"].getUInt(864000000);
@@ -187,7 +232,11 @@ int main(int argc, char **argv) {
 						PStorageFactory sf;
 
 						if (!storageBroker.defined()) {
-							sf = PStorageFactory(new StorageFactory(storagePath,storageVersions,storageBinary?Storage::binjson:Storage::json));
+							if (storageRecords) {
+								sf = PStorageFactory(new RecordStorageFactory(storagePath,storageVersions,storageBinary?Storage::binjson:Storage::json));
+							} else {
+								sf = PStorageFactory(new StorageFactory(storagePath,storageVersions,storageBinary?Storage::binjson:Storage::json));
+							}
 						} else {
 							sf = PStorageFactory(new ExtStorage(storageBroker.getCurPath(), "storage_broker", storageBroker.getString(), brk_timeout));
 							auto bl = servicesection["backup_locally"].getBool(false);
@@ -223,6 +272,52 @@ int main(int argc, char **argv) {
 								sch,app.config["brokers"], app.test,sf,rpt,perfmod, rptpath,  brk_timeout
 						);
 
+						std::shared_ptr<TraderExecutor> executor;
+						if (trader_threads) {
+							TraderExecutor::Limits limits;
+							for (auto &&def: app.config["broker_concurrency"]) {
+								StrViewA name = def.first;
+								limits.emplace(std::string(name.data, name.length), def.second.getUInt(broker_concurrency));
+							}
+							executor = std::make_shared<TraderExecutor>(trader_threads, broker_concurrency, std::move(limits));
+							logNote("Traders run on worker pool: threads=$1, broker_concurrency=$2", trader_threads, broker_concurrency);
+						}
+
+						//count of traders of the scheduler's cycle which have not been performed yet
+						auto cycle_pending = std::make_shared<std::atomic<std::size_t> >(0);
+
+						std::shared_ptr<TraderWakeup> wakeup;
+						{
+							std::set<std::string, std::less<> > wakeup_events;
+							std::string evlist(wakeup_events_str.data, wakeup_events_str.length);
+							std::replace(evlist.begin(), evlist.end(), ',', ' ');
+							std::istringstream evstream(evlist);
+							std::string ev;
+							while (evstream >> ev) wakeup_events.insert(ev);
+							if (!wakeup_events.empty()) {
+								wakeup = std::make_shared<TraderWakeup>(sch, std::chrono::milliseconds(wakeup_debounce), std::move(wakeup_events),
+										[=](const TraderWakeup::Markets &markets) mutable {
+									//running cycle performs all traders and it needs the snapshot of
+									//the brokers, which would be dropped by the wakeup, so the wakeup is postponed
+									if (executor != nullptr && executor->isRunning()) return false;
+									if (*cycle_pending) return false;
+									traders.lock_shared()->wakeupTraders(markets);
+									Report::PendingDeltas deltas;
+									{
+										auto rptl = rpt.lock();
+										rptl->perfReport(perfmod.lock()->getReport());
+										deltas = rptl->genReport();
+									}
+									Report::sendDeltas(std::move(deltas));
+									return true;
+								});
+								traders.lock()->listenBrokers([wakeup](const std::string_view &broker, const std::string_view &event, const std::string_view &pair) {
+									wakeup->notify(broker, event, pair);
+								});
+								logNote("Traders are woken up by events: $1, debounce=$2 ms", wakeup_events_str, wakeup_debounce);
+							}
+						}
+
 						RefCntPtr<AuthUserList> aul;
 
 						StrViewA webadmin_auth = login_section["admin"].getString();
@@ -237,6 +332,7 @@ int main(int argc, char **argv) {
 						SharedObject<WebCfg::State> webcfgstate = SharedObject<WebCfg::State>::make(sf->create("web_admin_conf"),new AuthUserList, new AuthUserList);
 						webcfgstate.lock()->setAdminAuth(webadmin_auth);
 						webcfgstate.lock()->applyConfig(traders);
+						webcfgstate.lock()->backtest_cache.configure(backtest_cache_size, backtest_cache_spill);
 						aul = webcfgstate.lock_shared()->users;
 
 						std::unique_ptr<simpleServer::MiniHttpServer> srv;
@@ -266,6 +362,12 @@ int main(int argc, char **argv) {
 								"/",AuthMapper(name,aul,jwt, true) >>= simpleServer::HTTPMappedHandler(simpleServer::HttpFileMapper(std::string(rptpath), "index.html", 600))
 							});
 
+							paths.push_back({
+								"/api",AuthMapper(name,aul,jwt, true) >>= simpleServer::HTTPMappedHandler(
+										[rpt](simpleServer::HTTPRequest req, const ondra_shared::StrViewA &vpath) {
+									return reportFeed(rpt, req, vpath);
+								})
+							});
 							paths.push_back({
 								"/admin",ondra_shared::shared_function<bool(simpleServer::HTTPRequest, ondra_shared::StrViewA)>(WebCfg(webcfgstate,
 										name,
@@ -306,6 +408,60 @@ int main(int argc, char **argv) {
 
 						};
 
+						cntr.on("replay") >> [&](auto &&args, std::ostream &out){
+							if (args.length < 1) {
+								out << "Append arguments: <trader> [<price file>|-] [<assets> <currency>]" << std::endl;
+								return 1;
+							}
+							try {
+								auto tr = traders.lock_shared()->find(args[0]);
+								if (tr == nullptr) {
+									out << "Trader is not defined" << std::endl;
+									return 2;
+								}
+								MTrader::Config cfg;
+								Replay::Chart prices;
+								IStockApi::MarketInfo minfo;
+								{
+									auto trl = tr.lock_shared();
+									cfg = trl->getConfig();
+									minfo = trl->getMarketInfo();
+									if (args.length < 2 || args[1] == "-") {
+										auto chart = trl->getChart();
+										prices.assign(chart.begin(), chart.end());
+									}
+								}
+								if (args.length >= 2 && args[1] != "-") {
+									std::ifstream f(std::string(args[1].data, args[1].length));
+									if (!f) {
+										out << "Can't open price file" << std::endl;
+										return 2;
+									}
+									prices = Replay::parsePrices(f);
+								}
+								PStockApi src = traders.lock_shared()->stockSelector.getStock(cfg.broker);
+								if (src == nullptr) {
+									out << "Broker is not available" << std::endl;
+									return 2;
+								}
+								double assets, currency;
+								if (args.length >= 4) {
+									assets = std::strtod(std::string(args[2].data, args[2].length).c_str(), nullptr);
+									currency = std::strtod(std::string(args[3].data, args[3].length).c_str(), nullptr);
+								} else {
+									assets = src->getBalance(minfo.asset_symbol, cfg.pairsymb);
+									currency = src->getBalance(minfo.currency_symbol, cfg.pairsymb);
+								}
+								auto res = Replay::run(cfg, src, std::move(prices), assets, currency);
+								Replay::toJSON(res).toStream(out);
+								out << std::endl;
+								return 0;
+							} catch (std::exception &e) {
+								out << "Replay failed: " << e.what() << std::endl;
+								return 3;
+							}
+						};
+
 						cntr.on("admin") >> [&](auto &&, std::ostream &out){
 							std::random_device rnd;
 							std::uniform_int_distribution<int> dist(33,126);
@@ -325,24 +481,46 @@ int main(int argc, char **argv) {
 							sch.immediate() >> [logcap]{
 								ondra_shared::AbstractLogProvider::getInstance() = logcap->create();
 							};
+							if (executor != nullptr) {
+								executor->setThreadInit([logcap]{
+									ondra_shared::AbstractLogProvider::getInstance() = logcap->create();
+								});
+							}
 
 
 
 							auto report_cycle = [=]() mutable {
-								auto rptl = rpt.lock();
-								rptl->perfReport(perfmod.lock()->getReport());
-								rptl->genReport();
+								Report::PendingDeltas deltas;
+								{
+									auto rptl = rpt.lock();
+									rptl->perfReport(perfmod.lock()->getReport());
+									deltas = rptl->genReport();
+								}
+								Report::sendDeltas(std::move(deltas));
 							};
 
 							auto trader_cycle = [=]() mutable {
-								traders.lock()->resetBrokers();
+								if (executor != nullptr) {
+									executor->runCycle(traders, false, [&]{
+										//brokers are prepared in parallel, without the lock
+										auto jobs = traders.lock_shared()->prepareBrokers();
+										executor->runParallel(std::move(jobs));
+									}, [=]() mutable {
+										sch.immediate() >> report_cycle;
+									});
+									return;
+								}
+								auto jobs = traders.lock_shared()->prepareBrokers();
+								for (auto &&job: jobs) job();
 								traders.lock_shared()->enumTraders([&](const auto & trinfo){
-									sch.immediate()>>[tr = trinfo.second]()mutable{
+									++*cycle_pending;
+									sch.immediate()>>[tr = trinfo.second, cycle_pending]()mutable{
 										try {
 											tr.lock()->perform(false);
 										} catch (std::exception &e) {
 											logError("Scheduler exception: $1", e.what());
 										}
+										--*cycle_pending;
 									};
 								});
 								sch.after(std::chrono::seconds(1)) >> report_cycle;
@@ -360,9 +538,11 @@ int main(int argc, char **argv) {
 
 						cntr.dispatch();
 
+						if (wakeup != nullptr) wakeup->stop();
 						sch.removeAll();
 						logNote("---- Waiting to finish cycle ----");
 						sch.sync();
+						if (executor != nullptr) executor->wait();
 						traders.lock()->clear();
 					}
 					logNote("---- Exit ----");
@@ -10,12 +10,12 @@
 #include <imtjson/object.h>
 #include <imtjson/array.h>
 #include <numeric>
-#include <queue>
 #include <random>
 
 #include "../shared/stringview.h"
 #include "emulator.h"
 #include "ibrokercontrol.h"
+#include "record_storage.h"
 #include "sgn.h"
 #include "swap_broker.h"
 
@@ -106,6 +106,9 @@ MTrader::MTrader(IStockSelector &stock_selector,
 ,walletDB(walletDB)
 ,strategy(config.strategy)
 ,dynmult(cfg.dynmult_raise,cfg.dynmult_fall, cfg.dynmult_mode, cfg.dynmult_mult)
+//very old data are dropped from chart
+,chart(std::max<unsigned int>(std::max(cfg.spread_calc_sma_hours, cfg.spread_calc_stdev_hours),240*60))
+,spread_calc(cfg.spread_calc_sma_hours, cfg.spread_calc_stdev_hours)
 {
 	//probe that broker is valid configured
 	stock->testBroker();
@@ -189,11 +192,16 @@ void MTrader::perform(bool manually) {
 	try {
 		init();
 
+		//fetch data of this cycle in one exchange (if supported)
+		prefetchMarketStatus();
 
+		//prefetched data are used only by following requests
+		IBrokerBatch::Consumer prefetched;
 		//Get opened orders
 		auto orders = getOrders();
 		//get current status
 		auto status = getMarketStatus();
+		prefetched.release();
 
 		double eq = strategy.getEquilibrium(status.assetBalance);
 
@@ -424,12 +432,7 @@ void MTrader::perform(bool manually) {
 			if (chart.empty() || chart.back().time < status.chartItem.time) {
 				//store current price (to build chart)
 				chart.push_back(status.chartItem);
-				{
-					//delete very old data from chart
-					unsigned int max_count = std::max<unsigned int>(std::max(cfg.spread_calc_sma_hours, cfg.spread_calc_stdev_hours),240*60);
-					if (chart.size() > max_count)
-						chart.erase(chart.begin(),chart.end()-max_count);
-				}
+				spread_calc.push(status.chartItem.last);
 			}
 		}
 
@@ -555,6 +558,21 @@ static std::pair<double,double> sumTrades(const std::pair<double,double> &a, con
 	};
 }
 
+IBrokerSnapshot::Request MTrader::getSnapshotRequest() const {
+	//balances are fetched by getMarketStatus when they are not known, unless they are calculated internally
+	//(when new trades arrive, balances are fetched separately)
+	bool balances = !(cfg.internal_balance && internal_balance.has_value() && currency_balance.has_value())
+			&& (!internal_balance.has_value() || !currency_balance.has_value() || !currency_unadjusted_balance.has_value());
+	return {cfg.pairsymb, lastTradeId, minfo.asset_symbol, minfo.currency_symbol, balances};
+}
+
+void MTrader::prefetchMarketStatus() const {
+	IBrokerBatch *batch = dynamic_cast<IBrokerBatch *>(stock.get());
+	if (batch == nullptr) return;
+	auto req = getSnapshotRequest();
+	batch->prefetchMarketStatus(req.pair, req.lastId, req.asset, req.currency, req.balances);
+}
+
 MTrader::Status MTrader::getMarketStatus() const {
 
 	Status res;
@@ -619,7 +637,8 @@ MTrader::Status MTrader::getMarketStatus() const {
 
 	if (cfg.delayed_alerts && !trades.empty()) {
 		if (res.new_trades.trades.empty()) {
-			auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+			std::uint64_t now = replay_clock?ticker.time
+					:std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 			auto ellapsed = now - trades.back().time;
 			using TT = decltype(ellapsed);
 			TT period;
@@ -929,8 +948,24 @@ void MTrader::loadState() {
 			swapped = state["swapped"].getBool();
 		}
 		auto chartSect = st["chart"];
+		auto trSect = st["trades"];
+		IRecordStorage *rs = dynamic_cast<IRecordStorage *>(storage.get());
+		if (rs && !chartSect.defined() && !trSect.defined()) {
+			chart.clear();
+			spread_calc.clear();
+			trades.clear();
+			bool inv = state["chart_inverted"].getBool() != minfo.invert_price;
+			rs->loadRecords([&](const ChartItem &itm) {
+				if (inv) chart.push_back({itm.time, 1.0/itm.ask, 1.0/itm.bid, 1.0/itm.last});
+				else chart.push_back(itm);
+				spread_calc.push(chart.back().last);
+			}, [&](TWBItem &&itm) {
+				trades.push_back(std::move(itm));
+			});
+		}
 		if (chartSect.defined()) {
 			chart.clear();
+			spread_calc.clear();
 			for (json::Value v: chartSect) {
 				double ask = v["ask"].getNumber();
 				double bid = v["bid"].getNumber();
@@ -943,16 +978,14 @@ void MTrader::loadState() {
 				std::uint64_t tm = v["time"].getUIntLong();
 
 				chart.push_back({tm,ask,bid,last});
+				spread_calc.push(last);
 			}
 		}
-		{
-			auto trSect = st["trades"];
-			if (trSect.defined()) {
-				trades.clear();
-				for (json::Value v: trSect) {
-					TWBItem itm = TWBItem::fromJSON(v);
-					trades.push_back(itm);
-				}
+		if (trSect.defined()) {
+			trades.clear();
+			for (json::Value v: trSect) {
+				TWBItem itm = TWBItem::fromJSON(v);
+				trades.push_back(itm);
 			}
 		}
 		if (cfg.swap_symbols == swapped) {
@@ -962,7 +995,13 @@ void MTrader::loadState() {
 		if (cfg.dry_run) {
 			test_backup = st["test_backup"];
 			if (!test_backup.hasValue()) {
-				test_backup = st.replace("chart",json::Value());
+				test_backup = st.replace("chart",json::Value()).replace("records",json::Value());
+				if (!trSect.defined()) {
+					//trades were loaded from records, backup needs them
+					json::Array tr;
+					for (auto &&itm:trades) tr.push_back(itm.toJSON());
+					test_backup = test_backup.replace("trades", tr);
+				}
 			}
 		}
 
@@ -984,6 +1023,8 @@ void MTrader::loadState() {
 void MTrader::saveState() {
 	if (storage == nullptr || need_load) return;
 	json::Object obj;
+	//records are not used in the dry run, because the backup must be complete
+	IRecordStorage *rs = test_backup.hasValue()?nullptr:dynamic_cast<IRecordStorage *>(storage.get());
 
 	{
 		auto st = obj.object("state");
@@ -1002,8 +1043,9 @@ void MTrader::saveState() {
 		if (achieve_mode) st.set("achieve_mode", achieve_mode);
 		if (cfg.swap_symbols) st.set("swapped", cfg.swap_symbols);
 		if (need_initial_reset) st.set("need_initial_reset", need_initial_reset);
+		if (rs) st.set("chart_inverted", minfo.invert_price);
 	}
-	{
+	if (rs == nullptr) {
 		auto ch = obj.array("chart");
 		for (auto &&itm: chart) {
 			ch.push_back(json::Object("time", itm.time)
@@ -1012,7 +1054,7 @@ void MTrader::saveState() {
 				  ("last",minfo.invert_price?1.0/itm.last:itm.last));
 		}
 	}
-	{
+	if (rs == nullptr) {
 		auto tr = obj.array("trades");
 		for (auto &&itm:trades) {
 			tr.push_back(itm.toJSON());
@@ -1022,7 +1064,13 @@ void MTrader::saveState() {
 	if (test_backup.hasValue()) {
 		obj.set("test_backup", test_backup);
 	}
-	storage->store(obj);
+	if (rs) {
+		rs->storeRecords(obj,
+				chart.view(),
+				IRecordStorage::TradeView(trades.data(), trades.size()));
+	} else {
+		storage->store(obj);
+	}
 }
 
 
@@ -1175,7 +1223,7 @@ void MTrader::reset(std::optional<double> achieve_pos) {
 }
 
 MTrader::Chart MTrader::getChart() const {
-	return chart;
+	return Chart(chart.begin(), chart.end());
 }
 
 
@@ -1227,38 +1275,6 @@ void MTrader::dropState() {
 }
 
 
-template<typename Iter>
-MTrader::SpreadCalcResult MTrader::stCalcSpread(Iter beg, Iter end, unsigned int input_sma, unsigned int input_stdev) {
-	input_sma = std::max<unsigned int>(input_sma,30);
-	input_stdev = std::max<unsigned int>(input_stdev,30);
-	std::queue<double> sma;
-	std::vector<double> mapped;
-	double avg = 0;
-	std::accumulate(beg, end, 0.0, [&](auto &&a, auto &&c) {
-		double h = 0.0;
-		if ( sma.size() >= input_sma) {
-			h = sma.front();
-			sma.pop();
-		}
-		double d = a + c - h;
-		sma.push(c);
-		avg = d/sma.size();
-		mapped.push_back(c - avg);
-		return d;
-	});
-
-	std::size_t i = mapped.size() >= input_stdev?mapped.size()-input_stdev:0;
-	auto iter = mapped.begin()+i;
-	auto mend = mapped.end();
-	auto stdev = std::sqrt(std::accumulate(iter, mend, 0.0, [&](auto &&v, auto &&c) {
-		return v + c*c;
-	})/std::distance(iter, mend));
-	return SpreadCalcResult{
-		std::log((stdev+avg)/avg),
-		avg
-	};
-}
-
 std::optional<double> MTrader::getInternalBalance() const {
 	if (cfg.internal_balance) return internal_balance;
 	else return std::optional<double>();
@@ -1271,14 +1287,10 @@ std::optional<double> MTrader::getInternalCurrencyBalance() const {
 
 MTrader::SpreadCalcResult MTrader::calcSpread() const {
 	if (chart.size() < 5) return SpreadCalcResult{0,0};
-	std::vector<double> values(chart.size());
-	std::transform(chart.begin(), chart.end(),  values.begin(), [&](auto &&c) {return c.last;});
-
-	SpreadCalcResult lnspread = stCalcSpread(values.begin(), values.end(), cfg.spread_calc_sma_hours, cfg.spread_calc_stdev_hours);
-
-	return lnspread;
-
-
+	return SpreadCalcResult{
+		spread_calc.getSpread(),
+		spread_calc.getCenter()
+	};
 }
 
 MTrader::VisRes MTrader::visualizeSpread(std::function<std::optional<ChartItem>()> &&source, double sma, double stdev,
@@ -1289,18 +1301,14 @@ MTrader::VisRes MTrader::visualizeSpread(std::function<std::optional<ChartItem>(
 	VisRes res;
 	double last = 0;
 	double last_price = 0;
-	std::vector<double> prices;
-	std::size_t isma = sma*60;
-	std::size_t istdev = stdev * 60;
-	std::size_t mx = std::max(isma+istdev, 2*istdev);
+	RollingSpread spread_calc(static_cast<unsigned int>(sma*60), static_cast<unsigned int>(stdev*60));
 	for (auto k = source(); k.has_value(); k = source()) {
 		double p = k->last;
 		if (last || sliding) {
 	/*		if (minfo.invert_price) p = 1.0/p;*/
-			prices.push_back(p);
-			auto spread_info = stCalcSpread(prices.end()-std::min(mx,prices.size()), prices.end(), sma*60, stdev*60);
-			double spread = spread_info.spread;
-			double center = sliding?spread_info.center:0;
+			spread_calc.push(p);
+			double spread = spread_calc.getSpread();
+			double center = sliding?spread_calc.getCenter():0;
 			double low = (center+last) * std::exp(-spread*mult*dynmult.getBuyMult());
 			double high = (center+last) * std::exp(spread*mult*dynmult.getSellMult());
 			if (sliding && last_price) {
@@ -1397,6 +1405,10 @@ bool MTrader::checkMinMaxBalance(double balance, double orderSize) const {
 }
 
 std::pair<bool, double> MTrader::limitOrderMinMaxBalance(double balance, double orderSize) const {
+	return limitOrderMinMaxBalance(cfg, minfo, balance, orderSize);
+}
+
+std::pair<bool, double> MTrader::limitOrderMinMaxBalance(const Config &cfg, const IStockApi::MarketInfo &minfo, double balance, double orderSize) {
 	const auto &min_balance = minfo.invert_price?cfg.max_balance:cfg.min_balance;
 	const auto &max_balance = minfo.invert_price?cfg.min_balance:cfg.max_balance;
 	double factor = minfo.invert_price?-1:1;
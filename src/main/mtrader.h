@@ -13,10 +13,13 @@
 
 #include <shared/ini_config.h>
 #include <imtjson/namedEnum.h>
+#include "ibrokercontrol.h"
 #include "idailyperfmod.h"
 #include "istatsvc.h"
 #include "storage.h"
 #include "report.h"
+#include "rolling_spread.h"
+#include "sliding_buffer.h"
 #include "strategy.h"
 #include "walletDB.h"
 
@@ -166,6 +169,10 @@ public:
 		std::size_t enable_alerts_after_minutes;
 	};
 
+	///Prefetches data for getOrders() and getMarketStatus() in one exchange, if the broker supports it
+	void prefetchMarketStatus() const;
+	///Returns request for the market snapshot (see IBrokerSnapshot)
+	IBrokerSnapshot::Request getSnapshotRequest() const;
 	Status getMarketStatus() const;
 
 	Order calculateOrder(double lastTradePrice,
@@ -192,7 +199,7 @@ public:
 			const ZigZagLevels &zlev) const;
 
 
-	Config getConfig() {return cfg;}
+	Config getConfig() const {return cfg;}
 
 	const IStockApi::MarketInfo &getMarketInfo() const {return minfo;}
 
@@ -214,6 +221,17 @@ public:
 	void setInternalBalancies(double assets, double currency);
 
 	PStockApi getBroker() const {return stock;}
+	///Limits order by min_balance and max_balance
+	/**
+	 * @param cfg trader's configuration
+	 * @param minfo market info
+	 * @param balance current balance (position) of assets
+	 * @param orderSize size of the order
+	 * @return pair, where first is true, if the order has been limited, and second is new size of the order
+	 */
+	static std::pair<bool, double> limitOrderMinMaxBalance(const Config &cfg, const IStockApi::MarketInfo &minfo, double balance, double orderSize);
+	///Current time is taken from the ticker instead of the system clock (replay of recorded prices)
+	void enableReplayClock() {replay_clock = true;}
 
 	struct VisRes {
 		struct Item {
@@ -273,6 +291,7 @@ protected:
 	bool first_cycle = true;
 	bool achieve_mode = false;
 	bool need_initial_reset = true;
+	bool replay_clock = false;
 	double lastPriceOffset = 0;
 	json::Value test_backup;
 	json::Value lastTradeId = nullptr;
@@ -281,8 +300,9 @@ protected:
 	using TradeItem = IStockApi::Trade;
 	using TWBItem = IStatSvc::TradeRecord;
 
-	std::vector<ChartItem> chart;
+	SlidingBuffer<ChartItem> chart;
 	TradeHistory trades;
+	RollingSpread spread_calc;
 
 	std::optional<double> internal_balance;
 	std::optional<double> currency_balance;
@@ -327,9 +347,6 @@ protected:
 
 	WalletDB::Key getWalletKey() const;
 private:
-	template<typename Iter>
-	static SpreadCalcResult stCalcSpread(Iter beg, Iter end, unsigned int input_sma, unsigned int input_stdev);
-
 
 	void initialize();
 	mutable std::uint64_t period_cache = 0;
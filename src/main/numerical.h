@@ -8,6 +8,9 @@
 #ifndef SRC_MAIN_NUMERICAL_H_
 #define SRC_MAIN_NUMERICAL_H_
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <type_traits>
 
 namespace {
@@ -17,46 +20,269 @@ const double accuracy = 1e-6;
 }
 
 
+///Counters of the numeric solvers (per thread)
+/**
+ * Allows to measure count of iterations per call. Reset the counters, perform
+ * the calculation and read the counters
+ */
+struct NumericSolverStats {
+	///count of searches
+	unsigned long calls = 0;
+	///count of evaluations of the function
+	unsigned long iterations = 0;
+	///count of fixed point searches
+	unsigned long fp_calls = 0;
+	///count of fixed point iterations
+	unsigned long fp_iterations = 0;
+	///count of fixed point searches resolved from a cache
+	unsigned long fp_cache_hits = 0;
+
+	void reset() {*this = NumericSolverStats();}
+	double iterationsPerCall() const {return calls?static_cast<double>(iterations)/calls:0.0;}
+	double fpIterationsPerCall() const {return fp_calls?static_cast<double>(fp_iterations)/fp_calls:0.0;}
+};
+
+inline NumericSolverStats &numeric_solver_stats() {
+	static thread_local NumericSolverStats stats;
+	return stats;
+}
+
+namespace numerical_impl {
+
+///Finds root in bracket using Brent's method
+/**
+ * @param fn function
+ * @param a first end of bracket
+ * @param fa value at a
+ * @param b second end of bracket
+ * @param fb value at b (must have opposite sign to fa)
+ * @param cnt remaining iterations
+ * @return root
+ */
 template<typename Fn>
-double numeric_search_r1(double middle, Fn &&fn) {
-	double min = 0;
-	double max = middle;
-	double ref = fn(middle);
-	if (ref == 0 || std::isnan(ref)) return middle;
-	double md = (min+max)/2;
+double brent(Fn &&fn, double a, double fa, double b, double fb, int cnt) {
+	auto &stats = numeric_solver_stats();
+	if (std::abs(fa) < std::abs(fb)) {std::swap(a,b);std::swap(fa,fb);}
+	double c = a, fc = fa;
+	double d = b - a, e = d;
+	while (--cnt) {
+		if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0)) {
+			c = a; fc = fa; d = b - a; e = d;
+		}
+		if (std::abs(fc) < std::abs(fb)) {
+			a = b; b = c; c = a;
+			fa = fb; fb = fc; fc = fa;
+		}
+		double tol = 0.25 * accuracy * std::abs(b);
+		double m = 0.5 * (c - b);
+		if (std::abs(m) <= tol || fb == 0) return b;
+		if (std::abs(e) >= tol && std::abs(fa) > std::abs(fb)) {
+			//interpolation (secant or inverse quadratic)
+			double s = fb / fa;
+			double p, q;
+			if (a == c) {
+				p = 2 * m * s;
+				q = 1 - s;
+			} else {
+				double qq = fa / fc;
+				double r = fb / fc;
+				p = s * (2 * m * qq * (qq - r) - (b - a) * (r - 1));
+				q = (qq - 1) * (r - 1) * (s - 1);
+			}
+			if (p > 0) q = -q; else p = -p;
+			if (2 * p < std::min(3 * m * q - std::abs(tol * q), std::abs(e * q))) {
+				e = d;
+				d = p / q;
+			} else {
+				d = m; e = m;
+			}
+		} else {
+			d = m; e = m;
+		}
+		a = b; fa = fb;
+		b = b + (std::abs(d) > tol ? d : (m > 0 ? tol : -tol));
+		fb = fn(b);
+		stats.iterations++;
+		if (std::isnan(fb)) return b;
+	}
+	return b;
+}
+
+///Finds root in bracket using Newton's method, falls back to bisection when step leaves the bracket
+template<typename Fn, typename DFn>
+double newton(Fn &&fn, DFn &&dfn, double a, double fa, double b, double fb, int cnt) {
+	auto &stats = numeric_solver_stats();
+	if (a > b) {std::swap(a,b);std::swap(fa,fb);}
+	double x = std::abs(fa) < std::abs(fb)?a:b;
+	double fx = std::abs(fa) < std::abs(fb)?fa:fb;
+	while (--cnt) {
+		double tol = 0.25 * accuracy * std::abs(x);
+		double nx = x - fx/dfn(x);
+		if (!std::isfinite(nx) || nx <= a || nx >= b) nx = (a+b)*0.5;
+		double dx = std::abs(nx - x);
+		x = nx;
+		fx = fn(x);
+		stats.iterations++;
+		if (std::isnan(fx) || fx == 0) return x;
+		if ((fx > 0) == (fa > 0)) {a = x; fa = fx;} else {b = x; fb = fx;}
+		if (dx <= tol || (b - a) <= 2 * tol) return x;
+	}
+	return x;
+}
+
+///Common part of numeric_search_r1 and numeric_search_r2
+/**
+ * Searches root of fn in range (0, top). The upper end is known (ref), the lower end
+ * is not known, so the range is halved until sign is changed. Then the root is
+ * searched in the bracket using the solver
+ *
+ * @param top upper end of the range
+ * @param ref value at top
+ * @param fn function
+ * @param solver function which finds the root in the bracket
+ * @return root, or the last tested value if the root was not found
+ */
+template<typename Fn, typename Solver>
+double search(double top, double ref, Fn &&fn, Solver &&solver) {
+	auto &stats = numeric_solver_stats();
+	stats.calls++;
+	double max = top;
+	double md = max/2;
 	int cnt = 1000;
-	while ((max - min) / md > accuracy && --cnt) {
+	while (--cnt) {
 		double v = fn(md);
-		if (std::isnan(v)) break;
+		stats.iterations++;
+		if (std::isnan(v)) return md;
 		double ml = v * ref;
-		if (ml > 0) max = md;
-		else if (ml < 0) min = md;
-		else return md;
-		md = (min+max)/2;
+		if (ml > 0) {
+			ref = v;
+			max = md;
+			md = max/2;
+		} else if (ml < 0) {
+			if ((max - md) / md <= 2*accuracy) return (max+md)/2;
+			return solver(md, v, max, ref, cnt);
+		} else {
+			return md;
+		}
 	}
 	return md;
+}
+
+}
+
+///Searches for root of the function below the given value
+/**
+ * @param middle starting value. The root is searched between 0 and this value
+ * @param fn function
+ * @return root. If root is not found, returns value near to zero
+ */
+template<typename Fn>
+double numeric_search_r1(double middle, Fn &&fn) {
+	double ref = fn(middle);
+	if (ref == 0 || std::isnan(ref)) return middle;
+	return numerical_impl::search(middle, ref, fn, [&](double a, double fa, double b, double fb, int cnt){
+		return numerical_impl::brent(fn, a, fa, b, fb, cnt);
+	});
+}
 
+///Searches for root of the function below the given value - using derivation
+/**
+ * @param middle starting value. The root is searched between 0 and this value
+ * @param fn function
+ * @param dfn derivation of the function
+ * @return root. If root is not found, returns value near to zero
+ */
+template<typename Fn, typename DFn>
+double numeric_search_r1(double middle, Fn &&fn, DFn &&dfn) {
+	double ref = fn(middle);
+	if (ref == 0 || std::isnan(ref)) return middle;
+	return numerical_impl::search(middle, ref, fn, [&](double a, double fa, double b, double fb, int cnt){
+		return numerical_impl::newton(fn, dfn, a, fa, b, fb, cnt);
+	});
 }
 
+///Searches for root of the function above the given value
+/**
+ * The search is performed in domain 1/x
+ *
+ * @param middle starting value. The root is searched between this value and infinity
+ * @param fn function
+ * @return root. If root is not found, returns very large value
+ */
 template<typename Fn>
 double numeric_search_r2(double middle, Fn &&fn) {
-	double min = 0;
-	double max = 1.0/middle;
 	double ref = fn(middle);
 	if (ref == 0|| std::isnan(ref)) return middle;
-	double md = (min+max)/2;
-	int cnt = 1000;
-	while (md * (1.0 / min - 1.0 / max) > accuracy && --cnt) {
-		double v = fn(1.0/md);
-		if (std::isnan(v)) break;
-		double ml = v * ref;
-		if (ml > 0) max = md;
-		else if (ml < 0) min = md;
-		else return md;
-		md = (min+max)/2;
-	}
-	return 1.0/md;
+	auto ifn = [&](double x) {return fn(1.0/x);};
+	return 1.0/numerical_impl::search(1.0/middle, ref, ifn, [&](double a, double fa, double b, double fb, int cnt){
+		return numerical_impl::brent(ifn, a, fa, b, fb, cnt);
+	});
+}
 
+///Searches for root of the function above the given value - using derivation
+/**
+ * The search is performed in domain 1/x
+ *
+ * @param middle starting value. The root is searched between this value and infinity
+ * @param fn function
+ * @param dfn derivation of the function
+ * @return root. If root is not found, returns very large value
+ */
+template<typename Fn, typename DFn>
+double numeric_search_r2(double middle, Fn &&fn, DFn &&dfn) {
+	double ref = fn(middle);
+	if (ref == 0|| std::isnan(ref)) return middle;
+	auto ifn = [&](double x) {return fn(1.0/x);};
+	auto idfn = [&](double x) {return -dfn(1.0/x)/(x*x);};
+	return 1.0/numerical_impl::search(1.0/middle, ref, ifn, [&](double a, double fa, double b, double fb, int cnt){
+		return numerical_impl::newton(ifn, idfn, a, fa, b, fb, cnt);
+	});
+}
+
+///Finds fixed point of the function (x = fn(x))
+/**
+ * Uses simple iteration accelerated by Aitken's delta-squared process. The acceleration
+ * is disabled, when it doesn't reduce the step. Accelerated value is accepted only if
+ * it has the same sign as the iteration (so it can be used for prices)
+ *
+ * @param x initial value
+ * @param fn function
+ * @param maxiter maximum count of evaluations
+ * @return fixed point, or the last value if the iteration doesn't converge
+ */
+template<typename Fn>
+double numeric_fixed_point(double x, Fn &&fn, int maxiter = 100) {
+	auto &stats = numeric_solver_stats();
+	stats.fp_calls++;
+	double x0 = x;
+	double prevstep = std::numeric_limits<double>::infinity();
+	bool accel = true;
+	int iter = 0;
+	while (iter < maxiter) {
+		double x1 = fn(x0);
+		iter++;
+		stats.fp_iterations++;
+		if (!std::isfinite(x1)) return x0;
+		double step = std::abs(x1 - x0);
+		if (step <= accuracy * accuracy * std::abs(x1)) return x1;
+		if (step > prevstep) accel = false;
+		prevstep = step;
+		if (!accel || iter >= maxiter) {
+			x0 = x1;
+			continue;
+		}
+		double x2 = fn(x1);
+		iter++;
+		stats.fp_iterations++;
+		if (!std::isfinite(x2)) return x1;
+		step = std::abs(x2 - x1);
+		if (step <= accuracy * accuracy * std::abs(x2)) return x2;
+		prevstep = step;
+		double d = x2 - 2 * x1 + x0;
+		double xa = x2 - (x2 - x1) * (x2 - x1) / d;
+		x0 = std::isfinite(xa) && xa * x2 > 0 ? xa : x2;
+	}
+	return x0;
 }
 
 ///Calculate quadrature of given function in given range
@@ -0,0 +1,267 @@
+/*
+ * price_history.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "price_history.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <experimental/filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+
+static const char history_magic[4] = {'M','M','P','H'};
+static const std::uint32_t history_version = 1;
+
+static void writeVarInt(std::string &out, std::int64_t v) {
+	std::uint64_t z = (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+	while (z >= 0x80) {
+		out.push_back(static_cast<char>((z & 0x7F) | 0x80));
+		z >>= 7;
+	}
+	out.push_back(static_cast<char>(z));
+}
+
+static std::int64_t readVarInt(const std::string &in, std::size_t &pos) {
+	std::uint64_t z = 0;
+	unsigned int shift = 0;
+	while (true) {
+		if (pos >= in.size() || shift > 63) throw std::runtime_error("PriceHistory: corrupted data");
+		unsigned char c = static_cast<unsigned char>(in[pos++]);
+		z |= static_cast<std::uint64_t>(c & 0x7F) << shift;
+		if (!(c & 0x80)) break;
+		shift += 7;
+	}
+	return static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1);
+}
+
+PriceHistory::PriceHistory(const std::vector<BTPrice> &prc, double step, bool inverted)
+	:count(prc.size())
+{
+	double maxp = 0;
+	double minp = 0;
+	for (const auto &p: prc) {
+		double a = std::abs(p.price);
+		maxp = std::max(maxp, a);
+		if (a > 0 && (minp == 0 || a < minp)) minp = a;
+	}
+	//inverted prices are stored in the broker's space, the step doesn't apply
+	if (inverted) step = 0;
+	//the step must be much finer than the prices, and it must not change them
+	if (step > 0 && step > minp * 1e-6) step = 0;
+	if (step > 0) {
+		for (const auto &p: prc) {
+			double r = std::llround(p.price / step) * step;
+			if (std::abs(r - p.price) > std::abs(p.price) * 1e-9) {
+				step = 0;
+				break;
+			}
+		}
+	}
+	//ticks must fit to 52 bits, otherwise keep 12 significant digits
+	if (!(step > 0) || maxp / step > 4503599627370496.0) {
+		step = maxp > 0?std::pow(10.0, std::floor(std::log10(maxp)) - 11):1.0;
+	}
+	this->step = step;
+
+	times.reserve(count * 3);
+	prices.reserve(count * 2);
+	std::int64_t last_time = 0;
+	std::int64_t last_tick = 0;
+	for (const auto &p: prc) {
+		std::int64_t tm = static_cast<std::int64_t>(p.time);
+		std::int64_t tick = std::llround(p.price / step);
+		writeVarInt(times, tm - last_time);
+		writeVarInt(prices, tick - last_tick);
+		last_time = tm;
+		last_tick = tick;
+	}
+	times.shrink_to_fit();
+	prices.shrink_to_fit();
+}
+
+std::vector<BTPrice> PriceHistory::decode() const {
+	std::vector<BTPrice> res;
+	res.reserve(count);
+	std::size_t tpos = 0;
+	std::size_t ppos = 0;
+	std::int64_t tm = 0;
+	std::int64_t tick = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		tm += readVarInt(times, tpos);
+		tick += readVarInt(prices, ppos);
+		res.push_back(BTPrice{static_cast<std::uint64_t>(tm), tick * step});
+	}
+	return res;
+}
+
+template<typename T>
+static void writeRaw(std::ostream &out, const T &v) {
+	out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template<typename T>
+static T readRaw(std::istream &in) {
+	T v;
+	if (!in.read(reinterpret_cast<char *>(&v), sizeof(v))) throw std::runtime_error("PriceHistory: unexpected end of file");
+	return v;
+}
+
+static void writeString(std::ostream &out, const std::string &s) {
+	writeRaw<std::uint64_t>(out, s.size());
+	out.write(s.data(), s.size());
+}
+
+static std::string readString(std::istream &in) {
+	auto sz = readRaw<std::uint64_t>(in);
+	std::string s;
+	s.resize(sz);
+	if (sz && !in.read(&s[0], sz)) throw std::runtime_error("PriceHistory: unexpected end of file");
+	return s;
+}
+
+void PriceHistory::save(std::ostream &out) const {
+	out.write(history_magic, sizeof(history_magic));
+	writeRaw<std::uint32_t>(out, history_version);
+	writeRaw<std::uint64_t>(out, count);
+	writeRaw<double>(out, step);
+	writeString(out, times);
+	writeString(out, prices);
+}
+
+PriceHistory PriceHistory::load(std::istream &in) {
+	char m[4];
+	if (!in.read(m, sizeof(m)) || std::memcmp(m, history_magic, sizeof(m)) != 0
+			|| readRaw<std::uint32_t>(in) != history_version)
+		throw std::runtime_error("PriceHistory: invalid format");
+	PriceHistory res;
+	res.count = readRaw<std::uint64_t>(in);
+	res.step = readRaw<double>(in);
+	res.times = readString(in);
+	res.prices = readString(in);
+	return res;
+}
+
+PriceHistoryCache::PriceHistoryCache(std::size_t capacity, std::string spill_dir)
+	:capacity(std::max<std::size_t>(capacity,1)),spill_dir(std::move(spill_dir)) {}
+
+PriceHistoryCache::~PriceHistoryCache() {
+	clear();
+}
+
+void PriceHistoryCache::configure(std::size_t capacity, std::string spill_dir) {
+	clear();
+	this->capacity = std::max<std::size_t>(capacity,1);
+	this->spill_dir = std::move(spill_dir);
+	if (!this->spill_dir.empty()) {
+		std::error_code ec;
+		std::experimental::filesystem::create_directories(this->spill_dir, ec);
+	}
+}
+
+std::optional<PriceHistoryCache::Entry> PriceHistoryCache::get(const std::string &key) {
+	auto iter = index.find(key);
+	if (iter != index.end()) {
+		items.splice(items.begin(), items, iter->second);
+		return items.front().second;
+	}
+	auto e = unspill(key);
+	if (e.has_value()) put(key, Entry(*e));
+	return e;
+}
+
+void PriceHistoryCache::put(const std::string &key, Entry &&entry) {
+	auto iter = index.find(key);
+	if (iter != index.end()) {
+		items.erase(iter->second);
+		index.erase(iter);
+	}
+	if (spilled.erase(key)) std::remove(spillName(key).c_str());
+	items.emplace_front(key, std::move(entry));
+	index.emplace(key, items.begin());
+	while (items.size() > capacity) {
+		auto &last = items.back();
+		if (!spill_dir.empty()) spill(last.first, last.second);
+		index.erase(last.first);
+		items.pop_back();
+	}
+}
+
+void PriceHistoryCache::clear() {
+	items.clear();
+	index.clear();
+	for (const auto &k: spilled) std::remove(spillName(k).c_str());
+	spilled.clear();
+}
+
+std::string PriceHistoryCache::spillName(const std::string &key) const {
+	char buff[32];
+	std::snprintf(buff, sizeof(buff), "%016zx", std::hash<std::string>()(key));
+	return spill_dir + "/backtest_" + buff + ".bin";
+}
+
+void PriceHistoryCache::spill(const std::string &key, const Entry &entry) {
+	try {
+		std::string name = spillName(key);
+		std::ofstream f(name, std::ios::out|std::ios::trunc|std::ios::binary);
+		if (!f) return;
+		writeString(f, key);
+		const auto &m = entry.minfo;
+		writeString(f, m.asset_symbol);
+		writeString(f, m.currency_symbol);
+		writeString(f, m.inverted_symbol);
+		writeString(f, m.wallet_id);
+		writeRaw(f, m.asset_step);
+		writeRaw(f, m.currency_step);
+		writeRaw(f, m.min_size);
+		writeRaw(f, m.min_volume);
+		writeRaw(f, m.fees);
+		writeRaw(f, m.leverage);
+		writeRaw<int>(f, m.feeScheme);
+		writeRaw(f, m.invert_price);
+		writeRaw(f, m.simulator);
+		writeRaw(f, m.private_chart);
+		writeRaw(f, entry.reversed);
+		writeRaw(f, entry.inverted);
+		entry.prices.save(f);
+		if (f) spilled.insert(key);
+		else std::remove(name.c_str());
+	} catch (...) {
+		//spill is optional, failure drops the history
+	}
+}
+
+std::optional<PriceHistoryCache::Entry> PriceHistoryCache::unspill(const std::string &key) {
+	if (spilled.find(key) == spilled.end()) return {};
+	try {
+		std::ifstream f(spillName(key), std::ios::in|std::ios::binary);
+		if (!f || readString(f) != key) return {};
+		Entry e;
+		auto &m = e.minfo;
+		m.asset_symbol = readString(f);
+		m.currency_symbol = readString(f);
+		m.inverted_symbol = readString(f);
+		m.wallet_id = readString(f);
+		m.asset_step = readRaw<double>(f);
+		m.currency_step = readRaw<double>(f);
+		m.min_size = readRaw<double>(f);
+		m.min_volume = readRaw<double>(f);
+		m.fees = readRaw<double>(f);
+		m.leverage = readRaw<double>(f);
+		m.feeScheme = static_cast<IStockApi::FeeScheme>(readRaw<int>(f));
+		m.invert_price = readRaw<bool>(f);
+		m.simulator = readRaw<bool>(f);
+		m.private_chart = readRaw<bool>(f);
+		e.reversed = readRaw<bool>(f);
+		e.inverted = readRaw<bool>(f);
+		e.prices = PriceHistory::load(f);
+		return e;
+	} catch (...) {
+		return {};
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * price_history.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_PRICE_HISTORY_H_
+#define SRC_MAIN_PRICE_HISTORY_H_
+#include <cstdint>
+#include <istream>
+#include <list>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "backtest.h"
+#include "istockapi.h"
+
+///Compressed history of prices (columnar format)
+/**
+ * Times and prices are stored in separate columns. Times are stored as differences
+ * between neighbouring times, prices are scaled to the price step (currency_step) and
+ * also stored as differences. Differences are encoded as variable-length integers
+ * (zigzag + 7 bits per byte), so usual series needs 3-5 bytes per price instead of 16
+ *
+ * Prices are rounded to the step. If the step is not known (zero), it is too small
+ * or too coarse for the range of prices, it would change some prices, or the prices
+ * are inverted, the step is calculated to keep 12 significant digits.
+ */
+class PriceHistory {
+public:
+
+	PriceHistory() {}
+	///Compresses prices
+	/**
+	 * @param prices prices
+	 * @param step price step (currency_step)
+	 * @param inverted prices are inverted (the step is not used)
+	 */
+	PriceHistory(const std::vector<BTPrice> &prices, double step, bool inverted = false);
+
+	///Decompresses prices
+	std::vector<BTPrice> decode() const;
+	///Count of prices
+	std::size_t size() const {return count;}
+	bool empty() const {return count == 0;}
+	///Size of compressed data in bytes
+	std::size_t compressedSize() const {return times.size() + prices.size();}
+	///Step used to scale prices
+	double getStep() const {return step;}
+
+	void save(std::ostream &out) const;
+	static PriceHistory load(std::istream &in);
+
+protected:
+	std::size_t count = 0;
+	double step = 0;
+	std::string times;
+	std::string prices;
+};
+
+///Cache of price histories used by backtests
+/**
+ * Keeps limited count of histories (least recently used history is dropped first). If the
+ * spill directory is set, dropped histories are stored to the disk and loaded back
+ * when they are requested again. Spilled files are removed by the function clear()
+ *
+ * @note The object is not MT safe, it is protected by the lock of the owner.
+ */
+class PriceHistoryCache {
+public:
+
+	struct Entry {
+		PriceHistory prices;
+		IStockApi::MarketInfo minfo;
+		bool reversed = false;
+		bool inverted = false;
+	};
+
+	///Construct cache
+	/**
+	 * @param capacity maximum count of histories kept in the memory
+	 * @param spill_dir directory where dropped histories are stored. Empty
+	 * string disables the spill
+	 */
+	PriceHistoryCache(std::size_t capacity = 8, std::string spill_dir = std::string());
+	PriceHistoryCache(const PriceHistoryCache &) = delete;
+	PriceHistoryCache &operator=(const PriceHistoryCache &) = delete;
+	~PriceHistoryCache();
+
+	///Changes capacity and spill directory, clears the cache
+	void configure(std::size_t capacity, std::string spill_dir);
+
+	///Finds the history, moves it to the front
+	std::optional<Entry> get(const std::string &key);
+	///Stores history
+	void put(const std::string &key, Entry &&entry);
+	///Removes all histories (including spilled files)
+	void clear();
+
+protected:
+	using List = std::list<std::pair<std::string, Entry> >;
+	std::size_t capacity;
+	std::string spill_dir;
+	List items;
+	std::unordered_map<std::string, List::iterator> index;
+	std::unordered_set<std::string> spilled;
+
+	std::string spillName(const std::string &key) const;
+	void spill(const std::string &key, const Entry &entry);
+	std::optional<Entry> unspill(const std::string &key);
+};
+
+
+#endif /* SRC_MAIN_PRICE_HISTORY_H_ */
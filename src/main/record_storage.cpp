@@ -0,0 +1,328 @@
+/*
+ * record_storage.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "record_storage.h"
+
+#include <cerrno>
+#include <cstring>
+#include <experimental/filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <imtjson/object.h>
+#include <imtjson/string.h>
+#include "../shared/logOutput.h"
+
+using namespace std::experimental::filesystem;
+using ondra_shared::logWarning;
+
+static_assert(sizeof(IStatSvc::ChartItem) == 32, "Unexpected size of ChartItem");
+
+RecordStorage::RecordStorage(std::string file, int versions, Format format)
+	:Storage(file, versions, format) {}
+
+std::string RecordStorage::chartSegmentName(std::uint64_t seg) const {
+	return file + ".chart." + std::to_string(seg);
+}
+
+std::string RecordStorage::tradesName(std::uint64_t gen) const {
+	return file + ".trades." + std::to_string(gen);
+}
+
+std::uint64_t RecordStorage::Meta::chartTotal() const {
+	return (chart_last - chart_first) * chart_segment_size + chart_last_count;
+}
+
+json::Value RecordStorage::Meta::toJSON() const {
+	return json::Object("version", 1)
+			("chart_rec", sizeof(ChartRecord))
+			("trade_rec", sizeof(TradeRecord))
+			("chart_first", chart_first)
+			("chart_last", chart_last)
+			("chart_last_count", chart_last_count)
+			("chart_skip", chart_skip)
+			("chart_last_time", chart_last_time)
+			("trades_gen", trades_gen)
+			("trades_count", trades_count)
+			("trades_last_time", trades_last_time)
+			("trades_last_id", trades_last_id)
+			("long_ids", long_ids);
+}
+
+RecordStorage::Meta RecordStorage::Meta::fromJSON(json::Value v) {
+	Meta m;
+	m.valid = v["version"].getUInt() == 1
+			&& v["chart_rec"].getUInt() == sizeof(ChartRecord)
+			&& v["trade_rec"].getUInt() == sizeof(TradeRecord);
+	if (m.valid) {
+		m.chart_first = v["chart_first"].getUIntLong();
+		m.chart_last = v["chart_last"].getUIntLong();
+		m.chart_last_count = v["chart_last_count"].getUIntLong();
+		m.chart_skip = v["chart_skip"].getUIntLong();
+		m.chart_last_time = v["chart_last_time"].getUIntLong();
+		m.trades_gen = v["trades_gen"].getUIntLong();
+		m.trades_count = v["trades_count"].getUIntLong();
+		m.trades_last_time = v["trades_last_time"].getUIntLong();
+		m.trades_last_id = v["trades_last_id"];
+		if (v["long_ids"].type() == json::object) m.long_ids = v["long_ids"];
+	}
+	return m;
+}
+
+void RecordStorage::store(json::Value data) {
+	//header contains everything, records are no longer valid
+	meta = Meta();
+	Storage::store(data);
+}
+
+json::Value RecordStorage::load() {
+	json::Value v = Storage::load();
+	meta = Meta::fromJSON(v["records"]);
+	return v;
+}
+
+void RecordStorage::erase() {
+	Storage::erase();
+	removeRecordFiles();
+	meta = Meta();
+}
+
+void RecordStorage::removeRecordFiles() {
+	path p(file);
+	path dir = p.parent_path();
+	if (dir.empty()) dir = ".";
+	std::string chart_prefix = p.filename().string()+".chart.";
+	std::string trades_prefix = p.filename().string()+".trades.";
+	std::error_code ec;
+	for (const auto &entry: directory_iterator(dir, ec)) {
+		std::string fname = entry.path().filename().string();
+		if (fname.compare(0, chart_prefix.length(), chart_prefix) == 0
+			|| fname.compare(0, trades_prefix.length(), trades_prefix) == 0) {
+			remove(entry.path(), ec);
+		}
+	}
+}
+
+void RecordStorage::storeRecords(json::Value header, const ChartView &chart, const TradeView &trades) {
+	std::vector<std::string> obsolete;
+	if (!meta.valid) {
+		//start new records, files of previous records are no longer referenced
+		removeRecordFiles();
+		Meta m;
+		m.valid = true;
+		m.chart_first = m.chart_last = meta.chart_last+1;
+		m.trades_gen = meta.trades_gen+1;
+		meta = m;
+	}
+	auto chart_first = meta.chart_first;
+	auto trades_gen = meta.trades_gen;
+
+	storeChart(chart);
+	storeTrades(trades);
+
+	//drop files after the header is stored - until then, they can be referenced
+	for (auto i = chart_first; i < meta.chart_first; i++) obsolete.push_back(chartSegmentName(i));
+	if (trades_gen != meta.trades_gen) obsolete.push_back(tradesName(trades_gen));
+
+	Storage::store(header.replace("records", meta.toJSON()));
+
+	for (const auto &n: obsolete) std::remove(n.c_str());
+}
+
+void RecordStorage::resetChart() {
+	meta.chart_first = meta.chart_last = meta.chart_last+1;
+	meta.chart_last_count = 0;
+	meta.chart_skip = 0;
+	meta.chart_last_time = 0;
+}
+
+void RecordStorage::storeChart(const ChartView &chart) {
+	if (chart.empty()) {
+		if (meta.chartTotal()) resetChart();
+		return;
+	}
+	std::size_t n = chart.length;
+	std::size_t pos = n;
+	while (pos > 0 && chart[pos-1].time > meta.chart_last_time) --pos;
+
+	//items which are already stored must be suffix of the stored records
+	if (pos > meta.chartTotal() - meta.chart_skip
+			|| (pos > 0 && chart[pos-1].time != meta.chart_last_time)) {
+		resetChart();
+		pos = 0;
+	}
+
+	std::vector<ChartRecord> buff;
+	while (pos < n) {
+		if (meta.chart_last_count == chart_segment_size) {
+			meta.chart_last++;
+			meta.chart_last_count = 0;
+		}
+		std::size_t cnt = std::min<std::size_t>(n - pos, chart_segment_size - meta.chart_last_count);
+		buff.clear();
+		for (std::size_t i = 0; i < cnt; i++) {
+			const ChartItem &itm = chart[pos+i];
+			buff.push_back({itm.time, itm.ask, itm.bid, itm.last});
+		}
+		appendFile(chartSegmentName(meta.chart_last),
+				meta.chart_last_count * sizeof(ChartRecord),
+				buff.data(), cnt * sizeof(ChartRecord));
+		meta.chart_last_count += cnt;
+		pos += cnt;
+	}
+	meta.chart_last_time = chart[n-1].time;
+
+	//compaction - drop segments, which no longer contain items of the chart
+	std::uint64_t skip = meta.chartTotal() - n;
+	while (skip >= chart_segment_size && meta.chart_first < meta.chart_last) {
+		meta.chart_first++;
+		skip -= chart_segment_size;
+	}
+	meta.chart_skip = skip;
+}
+
+void RecordStorage::storeTrades(const TradeView &trades) {
+	bool append = meta.trades_count <= trades.length
+			&& (meta.trades_count == 0 || (
+					trades[meta.trades_count-1].time == meta.trades_last_time
+					&& trades[meta.trades_count-1].id == meta.trades_last_id));
+	if (!append) {
+		//trades has been modified, start new file
+		meta.trades_gen++;
+		meta.trades_count = 0;
+		meta.trades_last_time = 0;
+		meta.trades_last_id = json::Value();
+		meta.long_ids = json::object;
+	}
+	if (meta.trades_count == trades.length) return;
+
+	std::vector<TradeRecord> buff;
+	buff.reserve(trades.length - meta.trades_count);
+	for (std::size_t i = meta.trades_count; i < trades.length; i++) {
+		const TradeItem &t = trades[i];
+		TradeRecord r;
+		std::memset(&r, 0, sizeof(r));
+		r.time = t.time;
+		r.size = t.size;
+		r.price = t.price;
+		r.eff_size = t.eff_size;
+		r.eff_price = t.eff_price;
+		r.norm_profit = t.norm_profit;
+		r.norm_accum = t.norm_accum;
+		r.neutral_price = t.neutral_price;
+		r.flags = t.manual_trade?flag_manual:0;
+		json::String id = t.id.stringify();
+		if (id.length() < sizeof(r.id)) {
+			r.id_len = static_cast<std::uint8_t>(id.length());
+			std::memcpy(r.id, id.c_str(), id.length());
+		} else {
+			r.id_len = long_id;
+			meta.long_ids = meta.long_ids.replace(std::to_string(i), t.id);
+		}
+		buff.push_back(r);
+	}
+	appendFile(tradesName(meta.trades_gen), meta.trades_count * sizeof(TradeRecord),
+			buff.data(), buff.size() * sizeof(TradeRecord));
+	meta.trades_count = trades.length;
+	meta.trades_last_time = trades[trades.length-1].time;
+	meta.trades_last_id = trades[trades.length-1].id;
+}
+
+void RecordStorage::loadRecords(const std::function<void(const ChartItem &)> &chart,
+		 	 	 	 	 	    const std::function<void(TradeItem &&)> &trades) {
+	if (!meta.valid) return;
+
+	try {
+		for (auto seg = meta.chart_first; seg <= meta.chart_last; seg++) {
+			std::size_t cnt = seg == meta.chart_last?meta.chart_last_count:chart_segment_size;
+			std::size_t from = seg == meta.chart_first?meta.chart_skip:0;
+			if (cnt <= from) continue;
+			mapFile(chartSegmentName(seg), cnt * sizeof(ChartRecord), [&](const void *ptr){
+				const ChartRecord *recs = reinterpret_cast<const ChartRecord *>(ptr);
+				for (std::size_t i = from; i < cnt; i++) {
+					const ChartRecord &r = recs[i];
+					chart(ChartItem{r.time, r.ask, r.bid, r.last});
+				}
+			});
+		}
+	} catch (std::exception &e) {
+		//chart is not critical, continue with partial chart
+		logWarning("Failed to load chart: $1 - $2", file, e.what());
+	}
+
+	if (meta.trades_count) {
+		mapFile(tradesName(meta.trades_gen), meta.trades_count * sizeof(TradeRecord), [&](const void *ptr){
+			const TradeRecord *recs = reinterpret_cast<const TradeRecord *>(ptr);
+			for (std::size_t i = 0; i < meta.trades_count; i++) {
+				const TradeRecord &r = recs[i];
+				json::Value id = r.id_len == long_id
+						?meta.long_ids[std::to_string(i)]
+						:json::Value::fromString(json::StrViewA(r.id, r.id_len));
+				trades(TradeItem(IStockApi::Trade{
+						id, r.time, r.size, r.price, r.eff_size, r.eff_price
+					}, r.norm_profit, r.norm_accum, r.neutral_price, (r.flags & flag_manual) != 0));
+			}
+		});
+	}
+}
+
+void RecordStorage::appendFile(const std::string &name, std::size_t offset, const void *data, std::size_t size) {
+	int fd = ::open(name.c_str(), O_WRONLY|O_CREAT|O_CLOEXEC, 0666);
+	if (fd < 0) {
+		throw std::runtime_error("Can't open the storage: "+name+" - "+std::strerror(errno));
+	}
+	const char *p = reinterpret_cast<const char *>(data);
+	//drop records which are not referenced by the header (incomplete write)
+	bool ok = ::ftruncate(fd, offset) == 0;
+	while (ok && size) {
+		auto r = ::pwrite(fd, p, size, offset);
+		if (r < 0) {
+			if (errno == EINTR) continue;
+			ok = false;
+		} else {
+			p += r;
+			offset += r;
+			size -= r;
+		}
+	}
+	int e = errno;
+	::close(fd);
+	if (!ok) {
+		throw std::runtime_error("Can't write the storage: "+name+" - "+std::strerror(e));
+	}
+}
+
+void RecordStorage::mapFile(const std::string &name, std::size_t size, const std::function<void(const void *)> &fn) {
+	int fd = ::open(name.c_str(), O_RDONLY|O_CLOEXEC);
+	if (fd < 0) {
+		throw std::runtime_error("Can't open the storage: "+name+" - "+std::strerror(errno));
+	}
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < size) {
+		::close(fd);
+		throw std::runtime_error("Storage file is truncated: "+name);
+	}
+	void *ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (ptr == MAP_FAILED) {
+		throw std::runtime_error("Can't map the storage: "+name+" - "+std::strerror(errno));
+	}
+	try {
+		fn(ptr);
+	} catch (...) {
+		::munmap(ptr, size);
+		throw;
+	}
+	::munmap(ptr, size);
+}
+
+PStorage RecordStorageFactory::create(std::string name) const {
+	return std::make_unique<RecordStorage>(path+"/"+ name, versions, format);
+}
@@ -0,0 +1,173 @@
+/*
+ * record_storage.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_RECORD_STORAGE_H_
+#define SRC_MAIN_RECORD_STORAGE_H_
+#include <cstdint>
+#include <functional>
+
+#include "../shared/stringview.h"
+#include "istatsvc.h"
+#include "storage.h"
+
+///Extension of the storage, which is able to store chart and trades as binary records
+/**
+ * Use dynamic_cast to retrieve this interface from the IStorage
+ */
+class IRecordStorage {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+	using TradeItem = IStatSvc::TradeRecord;
+	using ChartView = ondra_shared::StringView<ChartItem>;
+	using TradeView = ondra_shared::StringView<TradeItem>;
+
+	///Stores header and records
+	/**
+	 * @param header JSON header - contains state of the trader and strategy. The header
+	 * should not contain the chart and trades
+	 * @param chart whole current chart. Only items newer than the last stored item are written
+	 * @param trades whole current list of trades. Only new trades are written, unless
+	 * the list has been modified
+	 */
+	virtual void storeRecords(json::Value header, const ChartView &chart, const TradeView &trades) = 0;
+	///Loads records
+	/** Must be called after load(). If the loaded header doesn't refer any records, nothing is loaded
+	 *
+	 * @param chart callback receives chart items in order
+	 * @param trades callback receives trades in order
+	 */
+	virtual void loadRecords(const std::function<void(const ChartItem &)> &chart,
+							 const std::function<void(TradeItem &&)> &trades) = 0;
+
+	virtual ~IRecordStorage() {}
+};
+
+///Storage with append only segmented files for chart and trades
+/**
+ * The header (state and strategy) is stored by the Storage (including its versioning).
+ * Chart is stored in segments of fixed count of fixed-size records. Segments
+ * are dropped once they contain only items which are no longer in the chart. Trades
+ * are stored in a single file of fixed-size records. Only new records are written
+ * during each cycle. The trades file is rewritten only when the trades are
+ * modified (erased, reset). Files are mapped into memory during loading.
+ *
+ * Metadata about records are stored in the header under the key "records". Records
+ * beyond the counts stored in the header (after a crash) are ignored and overwritten
+ *
+ * The storage is able to load the header stored by plain Storage, so the existing
+ * data are migrated during the first save.
+ */
+class RecordStorage: public Storage, public IRecordStorage {
+public:
+
+	///Count of records in one chart segment
+	static constexpr std::size_t chart_segment_size = 1440;
+
+	RecordStorage(std::string file, int versions, Format format);
+
+	virtual void store(json::Value data) override;
+	virtual json::Value load() override;
+	virtual void erase() override;
+
+	virtual void storeRecords(json::Value header, const ChartView &chart, const TradeView &trades) override;
+	virtual void loadRecords(const std::function<void(const ChartItem &)> &chart,
+							 const std::function<void(TradeItem &&)> &trades) override;
+
+protected:
+
+	struct ChartRecord {
+		std::uint64_t time;
+		double ask;
+		double bid;
+		double last;
+	};
+
+	struct TradeRecord {
+		std::uint64_t time;
+		double size;
+		double price;
+		double eff_size;
+		double eff_price;
+		double norm_profit;
+		double norm_accum;
+		double neutral_price;
+		std::uint8_t flags;
+		///length of id, or long_id if it is stored in the header
+		std::uint8_t id_len;
+		///serialized id
+		char id[46];
+	};
+
+	static constexpr std::uint8_t flag_manual = 1;
+	static constexpr std::uint8_t long_id = 0xFF;
+
+	///Metadata about records - stored in the header
+	struct Meta {
+		bool valid = false;
+		//chart - index of first segment
+		std::uint64_t chart_first = 0;
+		//chart - index of last segment
+		std::uint64_t chart_last = 0;
+		//chart - count of records in the last segment
+		std::uint64_t chart_last_count = 0;
+		//chart - count of records in the first segment, which are no longer in the chart
+		std::uint64_t chart_skip = 0;
+		//chart - time of last stored record
+		std::uint64_t chart_last_time = 0;
+		//trades - generation of the file
+		std::uint64_t trades_gen = 0;
+		//trades - count of records
+		std::uint64_t trades_count = 0;
+		//trades - time of last stored record
+		std::uint64_t trades_last_time = 0;
+		//trades - id of last stored record
+		json::Value trades_last_id;
+		//trades - ids which don't fit to the record (index -> id)
+		json::Value long_ids = json::object;
+
+		json::Value toJSON() const;
+		static Meta fromJSON(json::Value v);
+		std::uint64_t chartTotal() const;
+	};
+
+	Meta meta;
+
+	std::string chartSegmentName(std::uint64_t seg) const;
+	std::string tradesName(std::uint64_t gen) const;
+
+	void storeChart(const ChartView &chart);
+	void storeTrades(const TradeView &trades);
+	void resetChart();
+	///Removes all files of records
+	void removeRecordFiles();
+
+	///Appends records to the file
+	/**
+	 * @param name name of the file
+	 * @param offset offset in bytes where to write. The file is truncated at this offset
+	 * @param data data to write
+	 * @param size size of data
+	 */
+	static void appendFile(const std::string &name, std::size_t offset, const void *data, std::size_t size);
+	///Maps file and calls the function with the content
+	/**
+	 * @param name name of the file
+	 * @param size expected size. If the file is shorter, the exception is thrown
+	 * @param fn function receives pointer to the mapped content
+	 */
+	static void mapFile(const std::string &name, std::size_t size, const std::function<void(const void *)> &fn);
+};
+
+class RecordStorageFactory: public StorageFactory {
+public:
+	using StorageFactory::StorageFactory;
+	virtual PStorage create(std::string name) const override;
+};
+
+
+#endif /* SRC_MAIN_RECORD_STORAGE_H_ */
@@ -0,0 +1,181 @@
+/*
+ * replay.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "replay.h"
+
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+
+#include "../pricegen/price_series.h"
+
+ReplayStockApi::ReplayStockApi(PStockApi source, const std::string_view &pair, Chart &&prices, double assets, double currency)
+	:source(source)
+	,prices(std::move(prices))
+	,minfo(source->getMarketInfo(pair))
+	,fees(source->getFees(pair))
+	,assets(assets)
+	,currency(currency)
+{
+	if (this->prices.empty()) throw std::runtime_error("Replay: no prices");
+	const ChartItem &itm = this->prices[0];
+	cur = Ticker{itm.bid, itm.ask, itm.last, itm.time};
+}
+
+ReplayStockApi::ReplayStockApi(const MarketInfo &minfo, double assets, double currency)
+	:minfo(minfo)
+	,fees(minfo.fees)
+	,assets(assets)
+	,currency(currency)
+{
+}
+
+bool ReplayStockApi::next() {
+	if (pos+1 >= prices.size()) return false;
+	++pos;
+	const ChartItem &itm = prices[pos];
+	cur = Ticker{itm.bid, itm.ask, itm.last, itm.time};
+	return true;
+}
+
+double ReplayStockApi::getBalance(const std::string_view &symb, const std::string_view &) {
+	if (symb == minfo.asset_symbol) return assets;
+	if (symb == minfo.currency_symbol) return currency;
+	return 0;
+}
+
+ReplayStockApi::TradesSync ReplayStockApi::syncTrades(json::Value , const std::string_view &) {
+	return {{}, nullptr};
+}
+
+ReplayStockApi::Orders ReplayStockApi::getOpenOrders(const std::string_view &) {
+	return {};
+}
+
+ReplayStockApi::Ticker ReplayStockApi::getTicker(const std::string_view &) {
+	return cur;
+}
+
+json::Value ReplayStockApi::placeOrder(const std::string_view &, double , double ,
+		json::Value , json::Value , double ) {
+	throw std::runtime_error("Replay: trading is not supported");
+}
+
+ReplayStockApi::MarketInfo ReplayStockApi::getMarketInfo(const std::string_view &) {
+	return minfo;
+}
+
+double ReplayStockApi::getFees(const std::string_view &) {
+	return fees;
+}
+
+std::vector<std::string> ReplayStockApi::getAllPairs() {
+	if (source == nullptr) return {};
+	return source->getAllPairs();
+}
+
+ReplayStockApi::BrokerInfo ReplayStockApi::getBrokerInfo() {
+	if (source == nullptr) return BrokerInfo{true, "replay"};
+	return source->getBrokerInfo();
+}
+
+namespace {
+
+class ReplayStockSelector: public IStockSelector {
+public:
+	ReplayStockSelector(PStockApi api):api(api) {}
+	virtual PStockApi getStock(const std::string_view &) const override {return api;}
+	virtual void forEachStock(EnumFn fn) const override {fn("replay", api);}
+protected:
+	PStockApi api;
+};
+
+class ReplayStatSvc: public IStatSvc {
+public:
+	virtual void reportOrders(const std::optional<IStockApi::Order> &,
+							  const std::optional<IStockApi::Order> &) override {}
+	virtual void reportTrades(ondra_shared::StringView<TradeRecord> ) override {}
+	virtual void reportPrice(double ) override {}
+	virtual void setInfo(const Info &) override {}
+	virtual void reportMisc(const MiscData &) override {}
+	virtual void reportError(const ErrorObj &) override {}
+	virtual void reportPerformance(const PerformanceReport &) override {}
+	virtual std::size_t getHash() const override {return std::hash<std::string_view>()("replay");}
+	virtual void clear() override {}
+};
+
+}
+
+std::unique_ptr<MTrader> Replay::createTrader(MTrader::Config cfg, PStockApi api) {
+	ReplayStockSelector selector(api);
+	cfg.dry_run = true;
+	auto trader = std::make_unique<MTrader>(selector, nullptr, std::make_unique<ReplayStatSvc>(), PWalletDB::make(), cfg);
+	trader->enableReplayClock();
+	return trader;
+}
+
+Replay::Result Replay::run(MTrader::Config cfg, PStockApi source, Chart &&prices, double assets, double currency) {
+	auto start = std::chrono::steady_clock::now();
+	auto api = std::make_shared<ReplayStockApi>(source, cfg.pairsymb, std::move(prices), assets, currency);
+	auto trader = createTrader(cfg, api);
+
+	Result res;
+	do {
+		trader->perform(false);
+		res.cycles++;
+	} while (api->next());
+
+	const auto &minfo = trader->getMarketInfo();
+	PStockApi emul = trader->getBroker();
+	res.trades = trader->getTrades();
+	res.assets = emul->getBalance(minfo.asset_symbol, cfg.pairsymb);
+	res.currency = emul->getBalance(minfo.currency_symbol, cfg.pairsymb);
+	res.last_price = api->getTicker(cfg.pairsymb).last;
+	res.duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	return res;
+}
+
+Replay::Chart Replay::parsePrices(std::istream &in) {
+	Chart res;
+	std::string line;
+	std::uint64_t tm = 0;
+	while (std::getline(in, line)) {
+		std::string_view ln(line);
+		if (PriceSeries::trimValue(ln).empty()) continue;
+		auto sep = ln.find(',');
+		try {
+			double price;
+			if (sep == ln.npos) {
+				price = std::stod(std::string(PriceSeries::trimValue(ln)));
+				tm += 60000;
+			} else {
+				tm = PriceSeries::parseTime(PriceSeries::trimValue(ln.substr(0, sep)));
+				price = std::stod(std::string(PriceSeries::trimValue(ln.substr(sep+1))));
+			}
+			if (price > 0 && std::isfinite(price)) res.push_back({tm, price, price, price});
+		} catch (std::exception &e) {
+			//skip headers and invalid lines
+		}
+	}
+	return res;
+}
+
+json::Value Replay::toJSON(const Result &res) {
+	json::Array trades;
+	trades.reserve(res.trades.size());
+	for (const auto &t: res.trades) trades.push_back(t.toJSON());
+	return json::Object("cycles", res.cycles)
+			("duration", res.duration)
+			("assets", res.assets)
+			("currency", res.currency)
+			("last_price", res.last_price)
+			("equity", res.assets * res.last_price + res.currency)
+			("trades", trades);
+}
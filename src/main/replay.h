@@ -0,0 +1,148 @@
+/*
+ * replay.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_REPLAY_H_
+#define SRC_MAIN_REPLAY_H_
+#include <istream>
+#include <vector>
+
+#include "istatsvc.h"
+#include "istockapi.h"
+#include "mtrader.h"
+
+///Stock api which serves recorded prices
+/**
+ * The object is used as data source of the EmulatorAPI during the replay. Each call
+ * of the function next() moves the time to the next recorded price. Market info and
+ * fees are read from the source broker only once. Balances are initial balances,
+ * because all trades are simulated by the EmulatorAPI
+ *
+ * The object can be also constructed without source broker and without recorded
+ * prices. Then prices are fed by the function setTicker()
+ */
+class ReplayStockApi: public IStockApi {
+public:
+
+	using ChartItem = IStatSvc::ChartItem;
+	using Chart = std::vector<ChartItem>;
+
+	///Construct the source
+	/**
+	 * @param source source broker - used to retrieve market info and fees
+	 * @param pair pair to replay
+	 * @param prices recorded prices
+	 * @param assets initial assets
+	 * @param currency initial currency
+	 */
+	ReplayStockApi(PStockApi source, const std::string_view &pair, Chart &&prices, double assets, double currency);
+	///Construct the source without broker
+	/**
+	 * @param minfo market info
+	 * @param assets initial assets
+	 * @param currency initial currency
+	 */
+	ReplayStockApi(const MarketInfo &minfo, double assets, double currency);
+
+	///Moves to next price
+	/**
+	 * @retval true moved
+	 * @retval false no more prices
+	 */
+	bool next();
+	///Sets current ticker
+	void setTicker(const Ticker &tk) {cur = tk;}
+
+	virtual double getBalance(const std::string_view & symb, const std::string_view & pair) override;
+	virtual TradesSync syncTrades(json::Value lastId, const std::string_view & pair) override;
+	virtual Orders getOpenOrders(const std::string_view & par) override;
+	virtual Ticker getTicker(const std::string_view & piar) override;
+	virtual json::Value placeOrder(const std::string_view & pair,
+			double size, double price,json::Value clientId,
+			json::Value replaceId,double replaceSize) override;
+	virtual bool reset() override {return true;}
+	virtual MarketInfo getMarketInfo(const std::string_view & pair) override;
+	virtual double getFees(const std::string_view &pair) override;
+	virtual std::vector<std::string> getAllPairs() override;
+	virtual void testBroker() override {}
+	virtual BrokerInfo getBrokerInfo() override;
+
+protected:
+	PStockApi source;
+	Chart prices;
+	std::size_t pos = 0;
+	Ticker cur = {0,0,0,0};
+	MarketInfo minfo;
+	double fees;
+	double assets;
+	double currency;
+};
+
+///Runs full trader (MTrader) over recorded prices
+/**
+ * The trader runs in dry run mode against the EmulatorAPI fed by the ReplayStockApi.
+ * Each recorded price is one cycle of the trader. Trader has no storage and no
+ * reports, so the replay runs as fast as possible
+ */
+class Replay {
+public:
+
+	using Chart = ReplayStockApi::Chart;
+
+	struct Result {
+		///trades generated during the replay
+		MTrader::TradeHistory trades;
+		///count of processed cycles
+		std::size_t cycles = 0;
+		///assets at the end of the replay
+		double assets = 0;
+		///currency at the end of the replay
+		double currency = 0;
+		///last price
+		double last_price = 0;
+		///duration of the replay in milliseconds
+		std::uint64_t duration = 0;
+	};
+
+	///Runs the replay
+	/**
+	 * @param cfg configuration of the trader
+	 * @param source source broker (for market info)
+	 * @param prices recorded prices
+	 * @param assets initial assets
+	 * @param currency initial currency
+	 * @return result of the replay
+	 */
+	static Result run(MTrader::Config cfg, PStockApi source, Chart &&prices, double assets, double currency);
+
+	///Creates trader for the replay
+	/**
+	 * The trader runs in dry run mode against the EmulatorAPI, which uses the api
+	 * as data source. The trader has no storage and no reports. Time is taken from the ticker
+	 *
+	 * @param cfg configuration of the trader
+	 * @param api replay source
+	 * @return trader
+	 */
+	static std::unique_ptr<MTrader> createTrader(MTrader::Config cfg, PStockApi api);
+
+	///Parses price file
+	/**
+	 * Each line contains time and price separated by comma. Time is either ISO 8601
+	 * string ("2019-06-30T17:35:47.822Z"), or timestamp in milliseconds. The time can
+	 * be omitted, then one minute between prices is assumed. Values can be quoted
+	 *
+	 * @param in input stream
+	 * @return recorded prices
+	 */
+	static Chart parsePrices(std::istream &in);
+
+	///Exports result as JSON
+	static json::Value toJSON(const Result &res);
+};
+
+
+#endif /* SRC_MAIN_REPLAY_H_ */
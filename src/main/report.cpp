@@ -25,24 +25,123 @@ using namespace std::chrono;
 using namespace json;
 
 void Report::setInterval(std::uint64_t interval) {
-	this->interval_in_ms = interval;
+	if (this->interval_in_ms != interval) {
+		this->interval_in_ms = interval;
+		dirty = sectAll;
+		chartResetRev = counter;
+	}
 }
 
 
-void Report::genReport() {
+Report::PendingDeltas Report::genReport() {
+
+	//rebuild only changed sections
+	if (dirty & sectCharts) {
+		if (chartResetRev == counter || !charts.defined()) {
+			Object o;exportCharts(std::move(o));charts = o;
+		} else {
+			//replace only charts of traders changed in this revision
+			Object o(charts);
+			for (auto &&r: chartRevMap) {
+				if (r.second == counter) o.set(r.first, tradeMap[r.first]);
+			}
+			charts = o;
+		}
+	}
+	if (dirty & sectOrders) {Array o;exportOrders(std::move(o));orders = o;}
+	if (dirty & sectInfo) {Object o;exportTitles(std::move(o));titles = o;}
+	if (dirty & sectPrices) {Object o;exportPrices(std::move(o));prices = o;}
+	if (dirty & sectMisc) {Object o;exportMisc(std::move(o));misc = o;}
+	for (unsigned int i = 0; i < sectionCount; i++) {
+		if (dirty & (1U << i)) sectionRev[i] = counter;
+	}
+	dirty = 0;
 
 	Object st;
-	exportCharts(st.object("charts"));
-	exportOrders(st.array("orders"));
-	exportTitles(st.object("info"));
-	exportPrices(st.object("prices"));
-	exportMisc(st.object("misc"));
+	st.set("charts", charts);
+	st.set("orders", orders);
+	st.set("info", titles);
+	st.set("prices", prices);
+	st.set("misc", misc);
 	st.set("interval", interval_in_ms);
 	st.set("rev", counter++);
 	st.set("log", logLines);
 	st.set("performance", perfRep);
 	while (logLines.size()>30) logLines.erase(0);
-	report->store(st);
+	published = st;
+	//stored even if nothing changed, the revision tells clients that the bot is alive
+	report->store(published);
+
+	//deltas are only prepared here, sending them under the lock would block the traders
+	PendingDeltas out;
+	out.reserve(waiting.size());
+	for (auto &&x: waiting) out.emplace_back(std::move(x.second), getDelta(x.first));
+	waiting.clear();
+	return out;
+}
+
+void Report::sendDeltas(PendingDeltas &&deltas) {
+	for (auto &&x: deltas) {
+		try {
+			x.first(x.second);
+		} catch (std::exception &e) {
+			logError("Failed to send report delta: $1", e.what());
+		}
+	}
+}
+
+unsigned int Report::sectIndex(Section s) {
+	unsigned int idx = 0;
+	while ((1U << idx) != static_cast<unsigned int>(s)) idx++;
+	return idx;
+}
+
+json::Value Report::getDelta(std::size_t since) const {
+	if (!published.defined()) return Object("rev",0)("full",true);
+	std::size_t rev = published["rev"].getUInt();
+	if (since == 0 || since > rev) {
+		return published.replace("full", true);
+	}
+
+	static const std::pair<Section, const char *> sections[] = {
+			{sectOrders, "orders"},
+			{sectInfo, "info"},
+			{sectPrices, "prices"},
+			{sectMisc, "misc"},
+			{sectLog, "log"},
+			{sectPerformance, "performance"}
+	};
+
+	Object out;
+	out.set("rev", rev);
+	out.set("interval", published["interval"]);
+	for (auto &&s: sections) {
+		if (sectionRev[sectIndex(s.first)] > since) out.set(s.second, published[s.second]);
+	}
+	if (sectionRev[sectIndex(sectCharts)] > since) {
+		json::Value ch = published["charts"];
+		if (chartResetRev > since) {
+			out.set("charts", ch);
+		} else {
+			Object partial;
+			for (auto &&r: chartRevMap) {
+				if (r.second > since && r.second <= rev) partial.set(r.first, ch[r.first]);
+			}
+			out.set("charts", partial);
+			out.set("charts_partial", true);
+		}
+	}
+	return out;
+}
+
+std::optional<json::Value> Report::waitForDelta(std::size_t since, DeltaCallback &&cb) {
+	std::size_t rev = published["rev"].getUInt();
+	if (since == 0 || since != rev || waiting.size() >= max_waiting) {
+		return getDelta(since);
+	} else {
+		waiting.emplace_back(since, std::move(cb));
+		return {};
+	}
 }
 
 
@@ -64,18 +163,23 @@ void Report::setOrders(StrViewA symb, const std::optional<IStockApi::Order> &buy
 	OKey buyKey {symb, buyid};
 	OKey sellKey {symb, -buyid};
 
+	OValue buyVal {0,0};
+	OValue sellVal {0,0};
 	if (buy.has_value()) {
-		orderMap[buyKey] = {inverted?1.0/buy->price:buy->price, buy->size*buyid};
-	} else{
-		orderMap[buyKey] = {0, 0};
+		buyVal = {inverted?1.0/buy->price:buy->price, buy->size*buyid};
 	}
-
 	if (sell.has_value()) {
-		orderMap[sellKey] = {inverted?1.0/sell->price:sell->price, sell->size*buyid};
-	} else {
-		orderMap[sellKey] = {0, 0};
+		sellVal = {inverted?1.0/sell->price:sell->price, sell->size*buyid};
 	}
 
+	OValue &b = orderMap[buyKey];
+	OValue &s = orderMap[sellKey];
+	if (b.price != buyVal.price || b.size != buyVal.size
+			|| s.price != sellVal.price || s.size != sellVal.size) {
+		b = buyVal;
+		s = sellVal;
+		dirty |= sectOrders;
+	}
 
 }
 
@@ -100,39 +204,96 @@ static IStatSvc::TradeRecord sumTrades(const IStatSvc::TradeRecord &a, const ISt
 	);
 }
 
-void Report::setTrades(StrViewA symb, StringView<IStatSvc::TradeRecord> trades) {
+json::Value Report::addTradeGroup(TradeTotals &tt, const IStatSvc::TradeRecord &t, bool inverted, std::uint64_t first) {
+
+	double gain = (t.eff_price - tt.prev_price)*tt.pos ;
+
+	tt.prev_price = t.eff_price;
+	double prev_pos = tt.pos;
+
+	tt.cur_fromPos += gain;
+	tt.pos += t.eff_size;
+	if (prev_pos * t.eff_size > 0) {
+		tt.enter_price = (tt.enter_price*prev_pos + t.eff_price * t.eff_size)/tt.pos;
+	} else {
+		double sz = t.eff_size;
+		double ep = tt.enter_price;
+		if (tt.pos * prev_pos <=0) {
+			tt.enter_price = t.eff_price;
+			sz = -prev_pos;
+		}
+		tt.rpln += sz * (ep - t.eff_price);
+	}
 
-	using ondra_shared::range;
 
-	json::Array records;
+
+	double normch = (t.norm_accum - tt.pap) * t.eff_price + (t.norm_profit - tt.pnp);
+	tt.pap = t.norm_accum;
+	tt.pnp = t.norm_profit;
+	tt.normaccum = tt.normaccum || t.norm_accum != 0;
+
+	if (t.time < first) return Value();
+
+	return Object
+			("id", t.id)
+			("time", t.time)
+			("achg", (inverted?-1:1)*t.size)
+			("gain", gain)
+			("norm", t.norm_profit)
+			("normch", normch)
+			("nacum", tt.normaccum?Value((inverted?-1:1)*t.norm_accum):Value())
+			("pos", (inverted?-1:1)*tt.pos)
+			("pl", tt.cur_fromPos)
+			("rpl", tt.rpln)
+			("price", (inverted?1.0/t.price:t.price))
+			("p0",t.neutral_price?Value(inverted?1.0/t.neutral_price:t.neutral_price):Value())
+			("volume", fabs(t.eff_price*t.eff_size))
+			("man",t.manual_trade);
+}
+
+void Report::setTrades(StrViewA symb, StringView<IStatSvc::TradeRecord> trades) {
 
 	const json::Value &info = infoMap[symb];
 	bool inverted = info["inverted"].getBool();
-	double pos = info["po"].getNumber();
+	double po = info["po"].getNumber();
 
-	if (!trades.empty()) {
-
-		const auto &last = trades[trades.length-1];
-		std::uint64_t last_time = last.time;
-		std::uint64_t first = last_time - interval_in_ms;
+	TradeCalc &tc = tradeCalcMap[symb];
+	bool same_input = tc.valid && tc.inverted == inverted && tc.po == po && tc.interval == interval_in_ms;
 
+	if (same_input && tc.total == trades.length
+			&& (trades.empty() || trades[trades.length-1].id == tc.total_id)) {
+		//no new trades
+		return;
+	}
 
-		auto tend = trades.end();
-		auto iter = trades.begin();
-		auto &&t = *iter;
+	if (!same_input || trades.length < tc.count
+			|| (tc.count && (trades[tc.count-1].id != tc.last_id || trades[tc.count-1].time != tc.last_time))) {
+		//trades has been changed, recalculate everything
+		tc = TradeCalc();
+		tc.valid = true;
+		tc.inverted = inverted;
+		tc.po = po;
+		tc.interval = interval_in_ms;
+		tc.totals.pos = po;
+	}
 
+	json::Array records;
+	json::Value open_group;
 
-		double init_price = t.eff_price;
+	if (trades.length > tc.count) {
 
+		const auto &last = trades[trades.length-1];
+		std::uint64_t last_time = last.time;
+		std::uint64_t first = last_time - interval_in_ms;
 
-		double prev_price = init_price;
-		double cur_fromPos = 0;
-		double pnp = 0;
-		double pap = 0;
+		if (tc.count == 0) {
+			double init_price = trades[0].eff_price;
+			tc.totals.prev_price = init_price;
+			tc.totals.enter_price = init_price;
+		}
 
-		double enter_price = t.eff_price;
-		double rpln = 0;
-		bool normaccum = false;
+		auto tend = trades.end();
+		auto iter = trades.begin()+tc.count;
 
 		std::optional<IStatSvc::TradeRecord> tmpTrade;
 		const IStatSvc::TradeRecord *prevTrade = nullptr;
@@ -145,57 +306,18 @@ void Report::setTrades(StrViewA symb, StringView<IStatSvc::TradeRecord> trades)
 												|| iter->manual_trade)))
 				{
 
-				auto &&t = *prevTrade;
-
-				double gain = (t.eff_price - prev_price)*pos ;
-
-				prev_price = t.eff_price;
-				double prev_pos = pos;
-
-				cur_fromPos += gain;
-				pos += t.eff_size;
-				if (prev_pos * t.eff_size > 0) {
-					enter_price = (enter_price*prev_pos + t.eff_price * t.eff_size)/pos;
-				} else {
-					double sz = t.eff_size;
-					double ep = enter_price;
-					if (pos * prev_pos <=0) {
-						enter_price = t.eff_price;
-						sz = -prev_pos;
-					}
-					rpln += sz * (ep - t.eff_price);
-				}
-
-
-
-				double normch = (t.norm_accum - pap) * t.eff_price + (t.norm_profit - pnp);
-				pap = t.norm_accum;
-				pnp = t.norm_profit;
-				normaccum = normaccum || t.norm_accum != 0;
-
-
-
-				if (t.time >= first) {
-					records.push_back(Object
-							("id", t.id)
-							("time", t.time)
-							("achg", (inverted?-1:1)*t.size)
-							("gain", gain)
-							("norm", t.norm_profit)
-							("normch", normch)
-							("nacum", normaccum?Value((inverted?-1:1)*t.norm_accum):Value())
-							("pos", (inverted?-1:1)*pos)
-							("pl", cur_fromPos)
-							("rpl", rpln)
-							("price", (inverted?1.0/t.price:t.price))
-							("p0",t.neutral_price?Value(inverted?1.0/t.neutral_price:t.neutral_price):Value())
-							("volume", fabs(t.eff_price*t.eff_size))
-							("man",t.manual_trade)
-					);
+				if (iter == tend) {
+					//last group can be extended later, so it is calculated on copy of totals
+					TradeTotals tt = tc.totals;
+					open_group = addTradeGroup(tt, *prevTrade, inverted, first);
+					break;
 				}
+				json::Value r = addTradeGroup(tc.totals, *prevTrade, inverted, first);
+				if (r.defined()) tc.records.emplace_back(prevTrade->time, r);
+				tc.count = iter - trades.begin();
+				tc.last_time = trades[tc.count-1].time;
+				tc.last_id = trades[tc.count-1].id;
 				prevTrade = nullptr;
-				if (iter == tend)
-					break;
 			}
 			if (prevTrade == nullptr) {
 				prevTrade = &(*iter);
@@ -207,8 +329,21 @@ void Report::setTrades(StrViewA symb, StringView<IStatSvc::TradeRecord> trades)
 			++iter;
 		} while (true);
 
+		//drop records which are out of interval
+		while (!tc.records.empty() && tc.records.front().first < first) {
+			tc.records.pop_front();
+		}
+		for (const auto &r: tc.records) {
+			if (r.first >= first) records.push_back(r.second);
+		}
+		if (open_group.defined()) records.push_back(open_group);
 	}
+
+	tc.total = trades.length;
+	tc.total_id = trades.empty()?json::Value():trades[trades.length-1].id;
 	tradeMap[symb] = records;
+	chartRevMap[symb] = counter;
+	dirty |= sectCharts;
 }
 
 
@@ -229,7 +364,7 @@ bool Report::OKeyCmp::operator ()(const OKey& a, const OKey& b) const {
 }
 
 void Report::setInfo(StrViewA symb, const InfoObj &infoObj) {
-	infoMap[symb] = Object
+	json::Value v = Object
 			("title",infoObj.title)
 			("currency", infoObj.currencySymb)
 			("asset", infoObj.assetSymb)
@@ -239,6 +374,11 @@ void Report::setInfo(StrViewA symb, const InfoObj &infoObj) {
 			("emulated",infoObj.emulated)
 			("po", infoObj.position_offset)
 			("order", infoObj.order);
+	json::Value &cur = infoMap[symb];
+	if (cur != v) {
+		cur = v;
+		dirty |= sectInfo;
+	}
 }
 
 void Report::setPrice(StrViewA symb, double price) {
@@ -246,7 +386,12 @@ void Report::setPrice(StrViewA symb, double price) {
 	const json::Value &info = infoMap[symb];
 	bool inverted = info["inverted"].getBool();
 
-	priceMap[symb] = inverted?1.0/price:price;;
+	double &cur = priceMap[symb];
+	double v = inverted?1.0/price:price;
+	if (cur != v) {
+		cur = v;
+		dirty |= sectPrices;
+	}
 }
 
 
@@ -285,7 +430,12 @@ void Report::setError(StrViewA symb, const ErrorObj &errorObj) {
 	if (!errorObj.genError.empty()) obj.set("gen", errorObj.genError);
 	if (!errorObj.buyError.empty()) obj.set(inverted?"sell":"buy", errorObj.buyError);
 	if (!errorObj.sellError.empty()) obj.set(inverted?"buy":"sell", errorObj.sellError);
-	errorMap[symb] = obj;
+	json::Value v = obj;
+	json::Value &cur = errorMap[symb];
+	if (cur != v) {
+		cur = v;
+		dirty |= sectMisc;
+	}
 }
 
 void Report::exportMisc(json::Object &&out) {
@@ -298,6 +448,7 @@ void Report::exportMisc(json::Object &&out) {
 
 void Report::addLogLine(StrViewA ln) {
 	logLines.push_back(ln);
+	dirty |= sectLog;
 }
 
 using namespace ondra_shared;
@@ -369,7 +520,12 @@ void Report::setMisc(StrViewA symb, const MiscData &miscData) {
 				("mdmb", miscData.dynmult_buy)
 				("mdms", miscData.dynmult_sell);
 	}
-	miscMap[symb] = output;
+	json::Value v = output;
+	json::Value &cur = miscMap[symb];
+	if (cur != v) {
+		cur = v;
+		dirty |= sectMisc;
+	}
 }
 
 void Report::clear(StrViewA symb) {
@@ -378,7 +534,11 @@ void Report::clear(StrViewA symb) {
 	priceMap.erase(symb);
 	miscMap.erase(symb);
 	errorMap.erase(symb);
+	tradeCalcMap.erase(symb);
+	chartRevMap.erase(symb);
 	orderMap.clear();
+	dirty = sectAll;
+	chartResetRev = counter;
 }
 
 void Report::clear() {
@@ -387,12 +547,19 @@ void Report::clear() {
 	priceMap.clear();
 	miscMap.clear();
 	errorMap.clear();
+	tradeCalcMap.clear();
+	chartRevMap.clear();
 	orderMap.clear();
 	logLines.clear();
+	dirty = sectAll;
+	chartResetRev = counter;
 }
 
 void Report::perfReport(json::Value report) {
-	perfRep = report;
+	if (perfRep != report) {
+		perfRep = report;
+		dirty |= sectPerformance;
+	}
 }
 
 std::size_t Report::initCounter() {
@@ -9,8 +9,11 @@
 #define SRC_MAIN_REPORT_H_
 
 #include <imtjson/array.h>
+#include <deque>
+#include <functional>
 #include <string_view>
 #include <optional>
+#include <vector>
 #include "istockapi.h"
 #include "storage.h"
 #include "../shared/linear_map.h"
@@ -38,11 +41,47 @@ public:
 
 	Report(StoragePtr &&report, std::size_t interval_in_ms)
 		:report(std::move(report)),interval_in_ms(interval_in_ms)
-		,counter(initCounter()){}
+		,counter(initCounter()){
+		//charts of the first report are sent whole
+		chartResetRev = counter;
+	}
 
 
+	///Callback which receives delta of the report
+	using DeltaCallback = std::function<void(json::Value)>;
+	///Deltas prepared for waiting requests, they are sent by sendDeltas() outside of the lock
+	using PendingDeltas = std::vector<std::pair<DeltaCallback, json::Value> >;
+
 	void setInterval(std::uint64_t interval);
-	void genReport();
+	///Generates the report
+	/**
+	 * @return deltas for requests waiting for this report. Send them by sendDeltas()
+	 * after the report is unlocked
+	 */
+	PendingDeltas genReport();
+	///Sends deltas returned by genReport()
+	static void sendDeltas(PendingDeltas &&deltas);
+
+	///Returns changes of the report since given revision
+	/**
+	 * @param since revision known by the client. Use 0 to retrieve whole report
+	 * @return object which contains "rev" and sections changed after given revision. If
+	 * "full" is true, the object contains whole report. If "charts_partial" is true, the
+	 * section "charts" contains only changed traders, which must be merged with the
+	 * previous state
+	 */
+	json::Value getDelta(std::size_t since) const;
+	///Registers the callback which receives the delta once the report is newer than given revision
+	/**
+	 * If the report is already newer, the callback is not registered and the delta is
+	 * returned, the caller sends it after the report is unlocked. Otherwise the delta
+	 * is returned by next genReport() (even if nothing changed)
+	 *
+	 * @param since revision known by the client
+	 * @param cb callback
+	 * @return delta to send immediately, or no value, if the callback was registered
+	 */
+	std::optional<json::Value> waitForDelta(std::size_t since, DeltaCallback &&cb);
 
 	using StrViewA = ondra_shared::StrViewA;
 	template<typename T> using StringView = ondra_shared::StringView<T>;
@@ -82,11 +121,69 @@ protected:
 		bool operator()(const OKey &a, const OKey &b) const;
 	};
 
+	///Running totals calculated from the trades
+	struct TradeTotals {
+		double pos = 0;
+		double prev_price = 0;
+		double cur_fromPos = 0;
+		double pnp = 0;
+		double pap = 0;
+		double enter_price = 0;
+		double rpln = 0;
+		bool normaccum = false;
+	};
+
+	///State of chart calculation, allows to extend the chart by new trades
+	/**
+	 * Trades are grouped (trades at the same price and direction are merged). Closed groups
+	 * are calculated only once, the last group is calculated on every change, because
+	 * it can be extended by next trade
+	 */
+	struct TradeCalc {
+		bool valid = false;
+		bool inverted = false;
+		double po = 0;
+		std::uint64_t interval = 0;
+		//count of trades in closed groups
+		std::size_t count = 0;
+		//time of last trade in closed groups
+		std::uint64_t last_time = 0;
+		//id of last trade in closed groups
+		json::Value last_id;
+		//count of all trades processed
+		std::size_t total = 0;
+		//id of last trade processed
+		json::Value total_id;
+		//running totals after the closed groups
+		TradeTotals totals;
+		//records of closed groups (time, record)
+		std::deque<std::pair<std::uint64_t, json::Value> > records;
+	};
+
+	///Sections of the report - used to track changes
+	enum Section {
+		sectCharts = 1,
+		sectOrders = 2,
+		sectInfo = 4,
+		sectPrices = 8,
+		sectMisc = 16,
+		sectLog = 32,
+		sectPerformance = 64,
+		sectAll = 127
+	};
+
+	static constexpr unsigned int sectionCount = 7;
+	///maximum count of waiting requests
+	static constexpr std::size_t max_waiting = 256;
+	///converts section to index of sectionRev
+	static unsigned int sectIndex(Section s);
+
 	using OrderMap = ondra_shared::linear_map<OKey,OValue, OKeyCmp>;
 	using TradeMap = ondra_shared::linear_map<std::string, json::Value>;
 	using InfoMap = ondra_shared::linear_map<std::string, json::Value>;
 	using MiscMap = ondra_shared::linear_map<std::string, json::Value>;
 	using PriceMap = ondra_shared::linear_map<std::string, double>;
+	using TradeCalcMap = ondra_shared::linear_map<std::string, TradeCalc>;
 
 	OrderMap orderMap;
 	TradeMap tradeMap;
@@ -94,9 +191,25 @@ protected:
 	PriceMap priceMap;
 	MiscMap miscMap;
 	MiscMap errorMap;
+	TradeCalcMap tradeCalcMap;
 	json::Array logLines;
 	json::Value perfRep;
 
+	///sections changed since last report
+	unsigned int dirty = sectAll;
+	///cached sections
+	json::Value charts, orders, titles, prices, misc;
+	///last published report
+	json::Value published;
+	///revision of last change of each section
+	std::size_t sectionRev[sectionCount] = {};
+	///revision of last change of chart of each trader
+	ondra_shared::linear_map<std::string, std::size_t> chartRevMap;
+	///revision when list of charts has been reset (trader removed)
+	std::size_t chartResetRev = 0;
+	///requests waiting for next report (since, callback)
+	std::vector<std::pair<std::size_t, DeltaCallback> > waiting;
+
 	StoragePtr report;
 
 
@@ -105,6 +218,8 @@ protected:
 	void exportTitles(json::Object &&out);
 	void exportPrices(json::Object &&out);
 	void exportMisc(json::Object &&out);
+	///Adds group of trades to the totals, returns record, or undefined if the record is older than first
+	static json::Value addTradeGroup(TradeTotals &tt, const IStatSvc::TradeRecord &t, bool inverted, std::uint64_t first);
 	std::uint64_t interval_in_ms;
 
 	std::size_t counter;
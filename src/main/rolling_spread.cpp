@@ -0,0 +1,69 @@
+/*
+ * rolling_spread.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "rolling_spread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+RollingSpread::Ring::Ring(std::size_t size):data(std::max<std::size_t>(size,1)) {}
+
+double RollingSpread::Ring::push(double v) {
+	double h = 0;
+	if (used < data.size()) {
+		used++;
+	} else {
+		h = data[pos];
+	}
+	data[pos] = v;
+	pos++;
+	if (pos == data.size()) {
+		pos = 0;
+		//recalculate sum after each turn, it removes rounding errors
+		total = std::accumulate(data.begin(), data.begin()+used, 0.0);
+	} else {
+		total = total + v - h;
+	}
+	return h;
+}
+
+void RollingSpread::Ring::clear() {
+	pos = 0;
+	used = 0;
+	total = 0;
+}
+
+RollingSpread::RollingSpread(unsigned int sma_window, unsigned int stdev_window)
+	:sma(std::max<unsigned int>(sma_window,30))
+	,stdev(std::max<unsigned int>(stdev_window,30))
+{
+}
+
+void RollingSpread::push(double price) {
+	sma.push(price);
+	avg = sma.sum()/sma.size();
+	double d = price - avg;
+	stdev.push(d*d);
+	cnt++;
+}
+
+void RollingSpread::clear() {
+	sma.clear();
+	stdev.clear();
+	avg = 0;
+	cnt = 0;
+}
+
+double RollingSpread::getStdev() const {
+	if (stdev.size() == 0) return 0;
+	return std::sqrt(std::max(stdev.sum(),0.0)/stdev.size());
+}
+
+double RollingSpread::getSpread() const {
+	return std::log((getStdev()+avg)/avg);
+}
@@ -0,0 +1,72 @@
+/*
+ * rolling_spread.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_ROLLING_SPREAD_H_
+#define SRC_MAIN_ROLLING_SPREAD_H_
+#include <cstddef>
+#include <vector>
+
+///Calculates spread from the stream of prices
+/**
+ * Keeps moving average of prices (sma window) and standard deviation of the
+ * difference between the price and its average (stdev window). Every new price
+ * is processed in O(1). Both windows are backed by ring buffers with running
+ * sums. Sums are recalculated after each turn of the buffer to avoid accumulation of
+ * rounding errors.
+ */
+class RollingSpread {
+public:
+
+	///Construct calculator
+	/**
+	 * @param sma_window size of window of moving average (in samples)
+	 * @param stdev_window size of window of standard deviation (in samples)
+	 *
+	 * @note both windows have minimum of 30 samples
+	 */
+	RollingSpread(unsigned int sma_window, unsigned int stdev_window);
+
+	///Adds price
+	void push(double price);
+	///Clears state
+	void clear();
+
+	///Count of prices pushed since last clear()
+	std::size_t count() const {return cnt;}
+	///Current moving average
+	double getCenter() const {return avg;}
+	///Current standard deviation
+	double getStdev() const;
+	///Current spread as logarithm of the ratio (stdev+avg)/avg
+	double getSpread() const;
+
+protected:
+
+	class Ring {
+	public:
+		Ring(std::size_t size);
+		///Pushes value, returns value which was removed from the buffer, or 0
+		double push(double v);
+		void clear();
+		std::size_t size() const {return used;}
+		double sum() const {return total;}
+	protected:
+		std::vector<double> data;
+		std::size_t pos = 0;
+		std::size_t used = 0;
+		double total = 0;
+	};
+
+	Ring sma;
+	Ring stdev;
+	double avg = 0;
+	std::size_t cnt = 0;
+};
+
+
+
+#endif /* SRC_MAIN_ROLLING_SPREAD_H_ */
@@ -0,0 +1,145 @@
+/*
+ * shared_cache.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_SHARED_CACHE_H_
+#define SRC_MAIN_SHARED_CACHE_H_
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+///Concurrent cache of immutable snapshots
+/**
+ * Items are stored as shared_ptr to const data, so readers receive the snapshot without
+ * copying it, and the snapshot stays valid even if it is dropped from the cache. Keys are
+ * distributed to shards, each shard has own lock and own LRU list, so threads working
+ * with different keys don't contend. Total size of items is bounded by given limit
+ * (divided equally between shards). The least recently used items are dropped first,
+ * but at least one item per shard is always kept.
+ *
+ * All functions are MT safe, so the object can be accessed through the shared lock of
+ * the owner
+ */
+template<typename T>
+class SharedCache {
+public:
+
+	using PItem = std::shared_ptr<const T>;
+
+	///Construct cache
+	/**
+	 * @param max_size maximum total size of items (in units given to the function put())
+	 * @param shard_count count of shards
+	 */
+	explicit SharedCache(std::size_t max_size, std::size_t shard_count = 8)
+		:shards(std::max<std::size_t>(shard_count,1))
+		,shard_limit(max_size / shards.size()) {}
+
+	///Returns snapshot, or nullptr if not found
+	PItem get(const std::string &key) const {
+		Shard &s = getShard(key);
+		std::lock_guard<std::mutex> _(s.lock);
+		auto iter = s.index.find(key);
+		if (iter == s.index.end()) return nullptr;
+		s.items.splice(s.items.begin(), s.items, iter->second);
+		return iter->second->item;
+	}
+
+	///Stores snapshot
+	/**
+	 * @param key key
+	 * @param item snapshot
+	 * @param size size of the item (usually in bytes)
+	 */
+	void put(const std::string &key, PItem item, std::size_t size) const {
+		Shard &s = getShard(key);
+		std::lock_guard<std::mutex> _(s.lock);
+		auto iter = s.index.find(key);
+		if (iter != s.index.end()) {
+			s.total -= iter->second->size;
+			s.items.erase(iter->second);
+			s.index.erase(iter);
+		}
+		s.items.push_front(Node{key, std::move(item), size});
+		s.index.emplace(key, s.items.begin());
+		s.total += size;
+		while (s.total > shard_limit && s.items.size() > 1) {
+			const Node &n = s.items.back();
+			s.total -= n.size;
+			s.index.erase(n.key);
+			s.items.pop_back();
+		}
+	}
+
+	///Removes item
+	void erase(const std::string &key) const {
+		Shard &s = getShard(key);
+		std::lock_guard<std::mutex> _(s.lock);
+		auto iter = s.index.find(key);
+		if (iter != s.index.end()) {
+			s.total -= iter->second->size;
+			s.items.erase(iter->second);
+			s.index.erase(iter);
+		}
+	}
+
+	///Removes items which keys start by given prefix
+	void erasePrefix(const std::string &prefix) const {
+		for (Shard &s: shards) {
+			std::lock_guard<std::mutex> _(s.lock);
+			for (auto iter = s.items.begin(); iter != s.items.end();) {
+				if (iter->key.compare(0, prefix.length(), prefix) == 0) {
+					s.total -= iter->size;
+					s.index.erase(iter->key);
+					iter = s.items.erase(iter);
+				} else {
+					++iter;
+				}
+			}
+		}
+	}
+
+	///Removes all items
+	void clear() const {
+		for (Shard &s: shards) {
+			std::lock_guard<std::mutex> _(s.lock);
+			s.items.clear();
+			s.index.clear();
+			s.total = 0;
+		}
+	}
+
+protected:
+
+	struct Node {
+		std::string key;
+		PItem item;
+		std::size_t size;
+	};
+
+	struct Shard {
+		std::mutex lock;
+		std::list<Node> items;
+		std::unordered_map<std::string, typename std::list<Node>::iterator> index;
+		std::size_t total = 0;
+	};
+
+	mutable std::vector<Shard> shards;
+	std::size_t shard_limit;
+
+	Shard &getShard(const std::string &key) const {
+		return shards[std::hash<std::string>()(key) % shards.size()];
+	}
+};
+
+
+
+#endif /* SRC_MAIN_SHARED_CACHE_H_ */
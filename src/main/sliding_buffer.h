@@ -0,0 +1,80 @@
+/*
+ * sliding_buffer.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_SLIDING_BUFFER_H_
+#define SRC_MAIN_SLIDING_BUFFER_H_
+#include <algorithm>
+#include <vector>
+
+#include "../shared/stringview.h"
+
+///Fixed capacity buffer which drops the oldest items, while the content stays contiguous
+/**
+ * Works as ring buffer, but items are always stored in one continuous block of memory,
+ * so the content can be accessed as a single span. The buffer allocates
+ * capacity + 1/4 of capacity items. Once the allocated space is exhausted, the
+ * content is moved to the beginning of the space. This happens once per capacity/4 of
+ * pushes, so push_back() is O(1) amortized and never allocates memory after the buffer
+ * is filled.
+ */
+template<typename T>
+class SlidingBuffer {
+public:
+
+	using const_iterator = const T *;
+	using iterator = const T *;
+
+	///Construct buffer
+	/**
+	 * @param capacity maximum count of items. When more items are pushed, the oldest
+	 * items are dropped
+	 */
+	explicit SlidingBuffer(std::size_t capacity)
+		:capacity(std::max<std::size_t>(capacity,1))
+		,slack(std::max<std::size_t>(capacity/4,1)) {}
+
+	void push_back(const T &v) {
+		if (items.size() - offset >= capacity) {
+			offset++;
+		}
+		if (items.size() == capacity + slack) {
+			items.erase(items.begin(), items.begin()+offset);
+			offset = 0;
+		}
+		if (items.capacity() == 0) items.reserve(capacity + slack);
+		items.push_back(v);
+	}
+
+	void clear() {
+		items.clear();
+		offset = 0;
+	}
+
+	bool empty() const {return items.size() == offset;}
+	std::size_t size() const {return items.size() - offset;}
+	std::size_t getCapacity() const {return capacity;}
+
+	const T *data() const {return items.data()+offset;}
+	const T *begin() const {return data();}
+	const T *end() const {return items.data()+items.size();}
+	const T &front() const {return items[offset];}
+	const T &back() const {return items.back();}
+	const T &operator[](std::size_t idx) const {return items[offset+idx];}
+
+	///Returns content as a single span
+	ondra_shared::StringView<T> view() const {return ondra_shared::StringView<T>(data(), size());}
+
+protected:
+	std::vector<T> items;
+	std::size_t offset = 0;
+	std::size_t capacity;
+	std::size_t slack;
+};
+
+
+
+#endif /* SRC_MAIN_SLIDING_BUFFER_H_ */
@@ -247,13 +247,17 @@ double Strategy_Exponencial::findRoot(double w, double k, double p, double c) {
 	auto fn = [=](double x) {
 		return base_fn(x) + diff;
 	};
+	//derivation of the base_fn
+	auto dfn = [=](double x) {
+		return w * std::exp(-x/k) * x / k;
+	};
 
 	double pp = fn(p);
 	double r;
 	if (pp > 0) {
-		r = numeric_search_r1(p, std::move(fn));
+		r = numeric_search_r1(p, std::move(fn), std::move(dfn));
 	} else if (pp < 0) {
-		r = numeric_search_r2(p, std::move(fn));
+		r = numeric_search_r2(p, std::move(fn), std::move(dfn));
 	} else {
 		r = p;
 	}
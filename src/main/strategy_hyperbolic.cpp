@@ -40,9 +40,13 @@ IStrategy::MinMax Hyperbolic_Calculus::calcRoots(double power, double asym, doub
 	auto fncalc = [&](double x) {
 		return calcPosValue(power,asym, neutral, x) - balance;
 	};
+	//derivation of the position value is -position
+	auto dfncalc = [&](double x) {
+		return -calcPosition(power, asym, neutral, x);
+	};
 	double m = calcPrice0(neutral, asym);
-	double r1 = numeric_search_r1(m, fncalc);
-	double r2 = numeric_search_r2(m, fncalc);
+	double r1 = numeric_search_r1(m, fncalc, dfncalc);
+	double r2 = numeric_search_r2(m, fncalc, dfncalc);
 	return {r1,r2};
 }
 
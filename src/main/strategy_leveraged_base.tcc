@@ -13,6 +13,7 @@
 #include <cmath>
 
 #include "../imtjson/src/imtjson/string.h"
+#include "numerical.h"
 #include "sgn.h"
 
 
@@ -37,15 +38,53 @@ bool Strategy_Leveraged<Calc>::isValid() const {
 
 template<typename Calc>
 void Strategy_Leveraged<Calc>::recalcNewState(const PCalc &calc, const PConfig &cfg, State &nwst) {
+	//cache of results - repeated resets with the same inputs are common in backtests
+	struct CacheItem {
+		PCalc calc;
+		PConfig cfg;
+		State in;
+		State out;
+	};
+	static constexpr unsigned int cache_size = 16;
+	static thread_local CacheItem cache[cache_size];
+	static thread_local unsigned int cache_pos = 0;
+
+	auto same = [](const State &a, const State &b) {
+		return a.neutral_price == b.neutral_price && a.last_price == b.last_price
+				&& a.position == b.position && a.bal == b.bal
+				&& a.trend_cntr == b.trend_cntr;
+	};
+	for (const CacheItem &itm: cache) {
+		if (itm.calc == calc && itm.cfg == cfg && same(itm.in, nwst)) {
+			numeric_solver_stats().fp_cache_hits++;
+			//copy only results of the solver, other fields belong to the caller
+			nwst.neutral_price = itm.out.neutral_price;
+			nwst.power = itm.out.power;
+			nwst.val = itm.out.val;
+			nwst.redbal = itm.out.redbal;
+			return;
+		}
+	}
+	State in = nwst;
+
 	double adjbalance = std::abs(nwst.bal + cfg->external_balance) * cfg->power;
 	nwst.power = calc->calcPower(nwst.last_price, adjbalance, cfg->asym);
 	recalcNeutral(calc,cfg,nwst);
-	for (int i = 0; i < 100; i++) {
-		nwst.power = calc->calcPower(nwst.neutral_price, adjbalance, cfg->asym);
+	//neutral price is fixed point of calcPower + calcNeutral
+	double neutral = numeric_fixed_point(nwst.neutral_price, [&](double n){
+		nwst.neutral_price = n;
+		nwst.power = calc->calcPower(n, adjbalance, cfg->asym);
 		recalcNeutral(calc,cfg,nwst);
-	}
+		return nwst.neutral_price;
+	}, 100);
+	nwst.neutral_price = neutral;
+	nwst.power = calc->calcPower(nwst.neutral_price, adjbalance, cfg->asym);
+	recalcNeutral(calc,cfg,nwst);
 	nwst.val = calc->calcPosValue(nwst.power, calcAsym(cfg,nwst), nwst.neutral_price, nwst.last_price);
 	nwst.redbal = nwst.bal;
+
+	cache[cache_pos] = CacheItem{calc, cfg, in, nwst};
+	cache_pos = (cache_pos + 1) % cache_size;
 }
 
 template<typename Calc>
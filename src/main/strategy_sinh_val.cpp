@@ -69,10 +69,14 @@ IStrategy::MinMax SinhVal_Calculus::calcRoots(double power, double asym, double
 	auto fn = [=](double x) {
 		return calcPosValue(power, asym, neutral, x) - balance;
 	};
+	//derivation of the position value is -position (cheaper than the integral)
+	auto dfn = [=](double x) {
+		return -calcPosition(power, asym, neutral, x);
+	};
 	double p0 = calcPrice0(neutral, asym);
 	if (p0<0) p0 = 0;
-	double mnval = numeric_search_r1(p0, fn);
-	double mxval = numeric_search_r2(p0, fn);
+	double mnval = numeric_search_r1(p0, fn, dfn);
+	double mxval = numeric_search_r2(p0, fn, dfn);
 	return {mnval, mxval};
 }
 
@@ -7,6 +7,7 @@
 
 #include "strategy_stairs.h"
 
+#include <algorithm>
 #include <cmath>
 #include <imtjson/object.h>
 #include <imtjson/string.h>
@@ -127,13 +128,32 @@ void Strategy_Stairs::serie(Pattern pat, int maxstep, Fn &&fn) {
 	}
 }
 
+Strategy_Stairs::PTable Strategy_Stairs::buildTable(const Config &cfg) {
+	auto t = std::make_shared<Table>();
+	if (cfg.pattern != constant) {
+		std::size_t cnt = static_cast<std::size_t>(std::max<std::intptr_t>(cfg.max_steps, 0))+2;
+		t->pos.reserve(cnt);
+		t->bound.reserve(cnt);
+		double prevp = 0;
+		serie(cfg.pattern, cfg.max_steps, [&](int idx, double amount){
+			t->pos.push_back(amount);
+			t->bound.push_back(prevp+(amount - prevp)*0.5);
+			prevp = amount;
+			return t->pos.size() < cnt;
+		});
+	}
+	return t;
+}
+
 double Strategy_Stairs::stepToPos(std::intptr_t step) const {
 	if (cfg.pattern == constant) return step;
 	else {
 		double mlt = sgn(step);
-		std::intptr_t istep = std::abs(step);
+		std::size_t istep = std::abs(step);
+		if (istep < table->pos.size()) return table->pos[istep]*mlt;
+		//step outside of the table (imported state), calculate it
 		double res = 0;
-		serie(cfg.pattern, cfg.max_steps,[&](int idx, double amount){res = amount; return idx < istep;});
+		serie(cfg.pattern, cfg.max_steps,[&](int idx, double amount){res = amount; return static_cast<std::size_t>(idx) < istep;});
 		return res*mlt;
 	}
 }
@@ -145,14 +165,11 @@ std::intptr_t Strategy_Stairs::posToStep(double pos) const {
 		res = static_cast<std::intptr_t>(std::round(p)) * s;
 	}
 	else {
-		std::intptr_t r = 0;
-		double prevp = 0;
-		serie(cfg.pattern,cfg.max_steps, [&](int idx, double amount){
-			r = idx-1;
-			double diff = amount - prevp;
-			double pp = prevp+diff*0.5;
-			prevp = amount;
-			return pp<=p && r < cfg.max_steps;});
+		//find first step, which begins above the position
+		auto iter = std::upper_bound(table->bound.begin(), table->bound.end(), p, [](double p, double b){
+			return !(b <= p);
+		});
+		std::intptr_t r = std::distance(table->bound.begin(), iter) - 1;
 		res = r*s;
 	}
 	return std::min(std::max(res, -cfg.max_steps), cfg.max_steps);
@@ -225,7 +242,7 @@ std::pair<IStrategy::OnTradeResult, ondra_shared::RefCntPtr<const IStrategy> > S
 		OnTradeResult{
 			prevpos * (tradePrice - st.price) + (nst.value - st.value),
 			0,nst.enter,nst.open
-		},new Strategy_Stairs(cfg,nst)
+		},new Strategy_Stairs(cfg,table,nst)
 	};
 }
 
@@ -279,7 +296,7 @@ PStrategy Strategy_Stairs::onIdle(const IStockApi::MarketInfo &minfo,
 		}
 		nst.step = posToStep(nst.pos/nst.power);
 		nst.cfghash = getCfgHash();
-		g = new Strategy_Stairs(cfg, nst);
+		g = new Strategy_Stairs(cfg, table, nst);
 		if (g->isValid()) return g;
 		else {
 			logError("Invalid state: $1, assets: $2, currencies: $2", g->exportState().toString(), assets, currency);
@@ -294,13 +311,17 @@ double Strategy_Stairs::getEquilibrium(double) const {
 }
 
 PStrategy Strategy_Stairs::reset() const {
-	return new Strategy_Stairs(cfg);
+	return new Strategy_Stairs(cfg, table, State());
+}
+
+Strategy_Stairs::Strategy_Stairs(const Config &cfg):cfg(cfg),table(buildTable(cfg)) {
 }
 
-Strategy_Stairs::Strategy_Stairs(const Config &cfg):cfg(cfg) {
+Strategy_Stairs::Strategy_Stairs(const Config &cfg, const State &state):cfg(cfg),table(buildTable(cfg)),st(state) {
 }
 
-Strategy_Stairs::Strategy_Stairs(const Config &cfg, const State &state):cfg(cfg),st(state) {
+Strategy_Stairs::Strategy_Stairs(const Config &cfg, const PTable &table, const State &state)
+	:cfg(cfg),table(table),st(state) {
 }
 
 std::string_view Strategy_Stairs::id = "stairs";
@@ -341,7 +362,7 @@ PStrategy Strategy_Stairs::importState(json::Value src,const IStockApi::MarketIn
 		newst.power = 0;
 	}
 
-	return new Strategy_Stairs(cfg, newst);
+	return new Strategy_Stairs(cfg, table, newst);
 }
 double Strategy_Stairs::assetsToPos(double assets) const {
 	return assets - st.neutral_pos;
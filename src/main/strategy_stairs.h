@@ -8,6 +8,9 @@
 #ifndef SRC_MAIN_STRATEGY_STAIRS_H_
 #define SRC_MAIN_STRATEGY_STAIRS_H_
 
+#include <memory>
+#include <vector>
+
 #include "istrategy.h"
 
 class Strategy_Stairs: public IStrategy {
@@ -65,8 +68,19 @@ public:
 		bool sl = false;
 	};
 
+	///Precomputed positions of the steps for the configuration
+	struct Table {
+		///position of each step (0 ... max_steps+1)
+		std::vector<double> pos;
+		///boundaries between steps - position where the step k begins (0 ... max_steps+1)
+		std::vector<double> bound;
+	};
+
+	using PTable = std::shared_ptr<const Table>;
+
 	Strategy_Stairs(const Config &cfg);
 	Strategy_Stairs(const Config &cfg, const State &state);
+	Strategy_Stairs(const Config &cfg, const PTable &table, const State &state);
 	virtual ~Strategy_Stairs();
 	virtual IStrategy::OrderData getNewOrder(const IStockApi::MarketInfo &minfo,
 			double cur_price, double new_price, double dir, double assets,
@@ -101,6 +115,8 @@ public:
 	bool isMargin(const IStockApi::MarketInfo& minfo) const;
 protected:
 	const Config cfg;
+	///table is immutable, it is shared between all instances created from the same config
+	PTable table;
 	State st;
 
 	double calcPower(double price, double currency) const;
@@ -115,6 +131,7 @@ protected:
 
 	template<typename Fn>
 	static void serie(Pattern pat, int maxstep, Fn &&cb);
+	static PTable buildTable(const Config &cfg);
 	std::size_t getCfgHash() const;
 
 };
@@ -0,0 +1,185 @@
+/*
+ * trader_executor.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "trader_executor.h"
+
+#include "../shared/logOutput.h"
+
+using ondra_shared::logDebug;
+using ondra_shared::logInfo;
+using ondra_shared::logWarning;
+
+TraderExecutor::TraderExecutor(unsigned int threads, unsigned int default_limit, Limits &&limits)
+	:worker(ondra_shared::Worker::create(std::max(threads,1U)))
+	,default_limit(std::max(default_limit,1U))
+	,limits(std::move(limits))
+{
+}
+
+std::string_view TraderExecutor::brokerGroup(const std::string_view &broker) {
+	//subaccounts share connection with the main account
+	auto n = broker.rfind('~');
+	if (n == broker.npos) return broker;
+	else return broker.substr(0,n);
+}
+
+unsigned int TraderExecutor::getLimit(const std::string_view &broker) const {
+	auto iter = limits.find(broker);
+	if (iter == limits.end()) return default_limit;
+	else return std::max(iter->second,1U);
+}
+
+bool TraderExecutor::isRunning() const {
+	std::unique_lock _(lock);
+	return remain != 0;
+}
+
+void TraderExecutor::setThreadInit(ThreadInit &&fn) {
+	std::unique_lock _(lock);
+	thread_init = std::move(fn);
+}
+
+bool TraderExecutor::runCycle(const SharedObject<Traders> &traders, bool manually, Callback &&prepare, Callback &&done) {
+	std::unique_lock lk(lock);
+	if (remain) {
+		skipped++;
+		std::string pending;
+		for (auto &&q: queues) {
+			for (auto &&t: q.second.pending) {
+				if (!pending.empty()) pending.append(", ");
+				pending.append(t.name);
+			}
+		}
+		auto ellapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - cycle_start);
+		logWarning("Trader cycle overlaps - previous cycle is running $1 ms, $2 trader(s) remain, skipped $3 time(s). Waiting: $4",
+				ellapsed.count(), remain, skipped, pending);
+		return false;
+	}
+
+	skipped = 0;
+	queues.clear();
+	this->manually = manually;
+	this->done = std::move(done);
+	slowest_name.clear();
+	slowest_time = std::chrono::milliseconds(0);
+	cycle_start = Clock::now();
+
+	//the cycle is running since now, so the prepare is not run twice
+	remain = 1;
+	lk.unlock();
+	if (prepare) {
+		try {
+			prepare();
+		} catch (std::exception &e) {
+			ondra_shared::logError("Trader cycle - exception when preparing: $1", e.what());
+		}
+	}
+	lk.lock();
+	remain--;
+
+	traders.lock_shared()->enumTraders([&](const auto &trinfo) {
+		auto tr = trinfo.second.lock_shared();
+		std::string broker (brokerGroup(tr->getConfig().broker));
+		auto iter = queues.find(broker);
+		if (iter == queues.end()) {
+			BrokerQueue q;
+			q.limit = getLimit(broker);
+			iter = queues.emplace(broker, std::move(q)).first;
+		}
+		iter->second.pending.push_back(Task{tr->ident, trinfo.second});
+		remain++;
+	});
+
+	if (remain == 0) {
+		Callback cb = std::move(this->done);
+		lk.unlock();
+		if (cb) cb();
+		return true;
+	}
+
+	for (auto &&q: queues) {
+		startTask(q.first, q.second);
+	}
+	return true;
+}
+
+void TraderExecutor::startTask(const std::string &broker, BrokerQueue &q) {
+	while (q.running < q.limit && !q.pending.empty()) {
+		Task t = std::move(q.pending.front());
+		q.pending.pop_front();
+		q.running++;
+		worker >> [this, broker, t = std::move(t)]() mutable {
+			runTask(broker, std::move(t));
+		};
+	}
+}
+
+void TraderExecutor::initThread() {
+	thread_local const TraderExecutor *initialized = nullptr;
+	if (initialized != this) {
+		initialized = this;
+		if (thread_init) thread_init();
+	}
+}
+
+void TraderExecutor::runParallel(std::vector<Callback> &&fns) {
+	struct Sync {
+		std::mutex lock;
+		std::condition_variable cond;
+		std::size_t remain;
+	};
+	auto sync = std::make_shared<Sync>();
+	sync->remain = fns.size();
+	for (auto &&fn: fns) {
+		worker >> [this, sync, fn = std::move(fn)] {
+			initThread();
+			try {
+				fn();
+			} catch (std::exception &e) {
+				ondra_shared::logError("Trader cycle - exception: $1", e.what());
+			}
+			std::lock_guard _(sync->lock);
+			if (--sync->remain == 0) sync->cond.notify_all();
+		};
+	}
+	std::unique_lock lk(sync->lock);
+	sync->cond.wait(lk, [&]{return sync->remain == 0;});
+}
+
+void TraderExecutor::runTask(const std::string &broker, Task &&task) {
+	initThread();
+	auto start = Clock::now();
+	try {
+		task.trader.lock()->perform(manually);
+	} catch (std::exception &e) {
+		ondra_shared::logError("Trader $1 - exception: $2", task.name, e.what());
+	}
+	auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+	logDebug("Trader $1 (broker $2) - cycle latency: $3 ms", task.name, broker, latency.count());
+
+	std::unique_lock lk(lock);
+	if (latency >= slowest_time) {
+		slowest_time = latency;
+		slowest_name = task.name;
+	}
+	auto iter = queues.find(broker);
+	iter->second.running--;
+	startTask(broker, iter->second);
+	if (--remain == 0) {
+		auto total = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - cycle_start);
+		logInfo("Trader cycle finished in $1 ms, slowest trader: $2 ($3 ms)", total.count(), slowest_name, slowest_time.count());
+		Callback cb = std::move(done);
+		finished.notify_all();
+		lk.unlock();
+		if (cb) cb();
+	}
+}
+
+void TraderExecutor::wait() {
+	std::unique_lock lk(lock);
+	finished.wait(lk, [&]{return remain == 0;});
+}
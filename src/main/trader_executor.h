@@ -0,0 +1,120 @@
+/*
+ * trader_executor.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_TRADER_EXECUTOR_H_
+#define SRC_MAIN_TRADER_EXECUTOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "../shared/worker.h"
+#include "traders.h"
+
+///Executes trader cycle on a worker pool
+/**
+ * Traders which are connected to different brokers run concurrently. Traders which
+ * share the broker are limited by concurrency cap of that broker (default is 1, because
+ * the broker's pipe is serialized anyway). Subaccounts share cap with their main account.
+ *
+ * The executor never queues overlapping cycles. If the previous cycle is still running
+ * when new cycle is requested, the request is skipped and reported to the log
+ */
+class TraderExecutor {
+public:
+
+	using Limits = std::map<std::string, unsigned int, std::less<> >;
+	using Trader = SharedObject<NamedMTrader>;
+	using Callback = std::function<void()>;
+
+	///Construct executor
+	/**
+	 * @param threads count of threads in the pool
+	 * @param default_limit default concurrency cap per broker
+	 * @param limits concurrency caps for specified brokers
+	 */
+	TraderExecutor(unsigned int threads, unsigned int default_limit, Limits &&limits);
+
+	///Function called on each thread of the pool before its first task
+	using ThreadInit = std::function<void()>;
+
+	///Starts new cycle
+	/**
+	 * @param traders list of traders (locked after the prepare function finishes)
+	 * @param manually argument passed to perform()
+	 * @param prepare function called when the cycle starts, before any trader is
+	 * performed (reset of brokers, snapshots). It is not called when the request is skipped
+	 * @param done function called when cycle finishes (called from the worker thread)
+	 * @retval true cycle started
+	 * @retval false previous cycle is still running, this request has been skipped
+	 */
+	bool runCycle(const SharedObject<Traders> &traders, bool manually, Callback &&prepare, Callback &&done);
+
+	///Runs functions on the pool and waits until all of them finish
+	/**
+	 * Intended for the prepare function of the cycle (snapshots of brokers). Must not be
+	 * called from a thread of the pool
+	 */
+	void runParallel(std::vector<Callback> &&fns);
+
+	///Sets function which initializes threads of the pool (for example the log provider)
+	/** Must be called before the first cycle */
+	void setThreadInit(ThreadInit &&fn);
+
+	///Waits until the current cycle finishes
+	void wait();
+
+	bool isRunning() const;
+
+protected:
+
+	using Clock = std::chrono::steady_clock;
+
+	struct Task {
+		std::string name;
+		Trader trader;
+	};
+
+	struct BrokerQueue {
+		std::deque<Task> pending;
+		unsigned int running = 0;
+		unsigned int limit = 1;
+	};
+
+	using Queues = std::map<std::string, BrokerQueue, std::less<> >;
+
+	ondra_shared::Worker worker;
+	unsigned int default_limit;
+	Limits limits;
+
+	mutable std::mutex lock;
+	std::condition_variable finished;
+	Queues queues;
+	bool manually = false;
+	std::size_t remain = 0;
+	std::size_t skipped = 0;
+	Clock::time_point cycle_start;
+	Callback done;
+	ThreadInit thread_init;
+	std::string slowest_name;
+	std::chrono::milliseconds slowest_time;
+
+	unsigned int getLimit(const std::string_view &broker) const;
+	static std::string_view brokerGroup(const std::string_view &broker);
+
+	void startTask(const std::string &broker, BrokerQueue &q);
+	void runTask(const std::string &broker, Task &&task);
+	void initThread();
+};
+
+
+
+#endif /* SRC_MAIN_TRADER_EXECUTOR_H_ */
@@ -0,0 +1,60 @@
+/*
+ * trader_wakeup.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "trader_wakeup.h"
+
+#include "../shared/logOutput.h"
+
+using ondra_shared::logDebug;
+
+TraderWakeup::TraderWakeup(ondra_shared::Scheduler sch, std::chrono::milliseconds debounce,
+		std::set<std::string, std::less<> > &&events, Action &&action)
+	:sch(sch)
+	,debounce(debounce)
+	,events(std::move(events))
+	,action(std::move(action))
+{
+}
+
+void TraderWakeup::notify(const std::string_view &broker, const std::string_view &event, const std::string_view &pair) {
+	if (events.find(event) == events.end()) return;
+	std::lock_guard<std::mutex> _(lock);
+	if (stopped) return;
+	pending.emplace(std::string(broker), std::string(pair));
+	if (!scheduled) schedule();
+}
+
+void TraderWakeup::stop() {
+	std::lock_guard<std::mutex> _(lock);
+	stopped = true;
+	pending.clear();
+}
+
+void TraderWakeup::schedule() {
+	scheduled = true;
+	sch.after(debounce) >> [me = shared_from_this()]{
+		me->flush();
+	};
+}
+
+void TraderWakeup::flush() {
+	Markets markets;
+	{
+		std::lock_guard<std::mutex> _(lock);
+		scheduled = false;
+		if (stopped || pending.empty()) return;
+		markets.assign(pending.begin(), pending.end());
+		//notifications received during the action need next wakeup
+		pending.clear();
+	}
+	for (const auto &m: markets) logDebug("Wakeup: broker=$1, pair=$2", m.first, m.second);
+	bool done = action(markets);
+	std::lock_guard<std::mutex> _(lock);
+	if (stopped) return;
+	if (!done) pending.insert(markets.begin(), markets.end());
+	if (!pending.empty() && !scheduled) schedule();
+}
@@ -0,0 +1,74 @@
+/*
+ * trader_wakeup.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_TRADER_WAKEUP_H_
+#define SRC_MAIN_TRADER_WAKEUP_H_
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../shared/scheduler.h"
+
+///Wakes up traders when brokers notify about events
+/**
+ * Notifications arrive from threads of brokers. They are collected and after the debounce
+ * time, the action is called from the scheduler with list of affected markets. Multiple
+ * notifications of the same market during the debounce time cause single wakeup. The regular
+ * cycle is not affected, it still runs as a safety net
+ */
+class TraderWakeup: public std::enable_shared_from_this<TraderWakeup> {
+public:
+
+	///Affected market - broker and pair
+	using Market = std::pair<std::string, std::string>;
+	using Markets = std::vector<Market>;
+	///Action performs traders of the markets
+	/**
+	 * @retval true done
+	 * @retval false postponed, the markets are processed by the next wakeup
+	 */
+	using Action = std::function<bool(const Markets &)>;
+
+	///Construct object
+	/**
+	 * @param sch scheduler
+	 * @param debounce delay between the first notification and the wakeup
+	 * @param events list of events which wake up traders ("fill", "price")
+	 * @param action action performed
+	 */
+	TraderWakeup(ondra_shared::Scheduler sch, std::chrono::milliseconds debounce,
+			std::set<std::string, std::less<> > &&events, Action &&action);
+
+	///Receives notification (MT safe, doesn't block)
+	void notify(const std::string_view &broker, const std::string_view &event, const std::string_view &pair);
+	///Stops processing of notifications (pending wakeup is dropped)
+	void stop();
+
+protected:
+
+	ondra_shared::Scheduler sch;
+	std::chrono::milliseconds debounce;
+	std::set<std::string, std::less<> > events;
+	Action action;
+
+	std::mutex lock;
+	std::set<Market> pending;
+	bool scheduled = false;
+	bool stopped = false;
+
+	void schedule();
+	void flush();
+};
+
+
+
+#endif /* SRC_MAIN_TRADER_WAKEUP_H_ */
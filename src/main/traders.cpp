@@ -10,6 +10,10 @@
 
 #include "traders.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "../shared/countdown.h"
 #include "../shared/logOutput.h"
 #include "ext_stockapi.h"
@@ -170,12 +174,73 @@ static void resetBroker(const PStockApi &api) {
 	}
 }
 
-void Traders::resetBrokers() {
+void Traders::resetBrokers() const {
 	stockSelector.forEachStock([](json::StrViewA, const PStockApi &api) {
 		resetBroker(api);
 	});
 }
 
+std::vector<Traders::Job> Traders::prepareBrokers() const {
+	struct Prepare {
+		bool reset = false;
+		std::vector<IBrokerSnapshot::Request> reqs;
+	};
+	std::unordered_map<PStockApi, Prepare> brokers;
+	stockSelector.forEachStock([&](json::StrViewA, const PStockApi &api) {
+		brokers[api].reset = true;
+	});
+	for (auto &&t: traders) {
+		auto lt = t.second.lock_shared();
+		PStockApi api = lt->getBroker();
+		if (dynamic_cast<IBrokerSnapshot *>(api.get()) == nullptr) continue;
+		brokers[api].reqs.push_back(lt->getSnapshotRequest());
+	}
+	std::vector<Job> jobs;
+	for (auto &&b: brokers) {
+		jobs.push_back([api = b.first, p = std::move(b.second)] {
+			if (p.reset) resetBroker(api);
+			if (p.reqs.empty()) return;
+			try {
+				dynamic_cast<IBrokerSnapshot *>(api.get())->snapshotMarkets(p.reqs);
+			} catch (std::exception &e) {
+				logError("Exception when SNAPSHOT: $1", e.what());
+			}
+		});
+	}
+	return jobs;
+}
+
+void Traders::wakeupTraders(const std::vector<std::pair<std::string, std::string> > &markets) const {
+	std::unordered_set<PStockApi> brokers;
+	std::vector<SharedObject<NamedMTrader> > affected;
+	for (auto &&t: traders) {
+		auto lt = t.second.lock_shared();
+		const auto &cfg = lt->getConfig();
+		auto iter = std::find_if(markets.begin(), markets.end(), [&](const auto &m){
+			return m.first == cfg.broker && m.second == cfg.pairsymb;
+		});
+		if (iter == markets.end()) continue;
+		brokers.insert(lt->getBroker());
+		affected.push_back(t.second);
+	}
+	for (auto &&b: brokers) resetBroker(b);
+	for (auto &&t: affected) t.lock()->perform(false);
+}
+
+void Traders::listenBrokers(NotifyFn &&fn) {
+	stockSelector.forEachStock([&](std::string_view name, const PStockApi &api) {
+		IBrokerNotify *ntf = dynamic_cast<IBrokerNotify *>(api.get());
+		if (ntf == nullptr) return;
+		//subaccounts don't send notifications and notifications of the main account
+		//don't carry the subaccount, so traders on subaccounts are not woken up
+		IBrokerSubaccounts *sub = dynamic_cast<IBrokerSubaccounts *>(api.get());
+		if (sub && sub->isSubaccount()) return;
+		ntf->setNotifyCallback([fn, broker = std::string(name)](const std::string_view &event, const std::string_view &pair) {
+			fn(broker, event, pair);
+		});
+	});
+}
+
 /*void Traders::runTraders(bool manually) {
 
 	if (worker.defined()) {
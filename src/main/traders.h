@@ -82,7 +82,28 @@ public:
 		for (auto k: traders) fn(std::move(k));
 	}
 
-	void resetBrokers();
+	void resetBrokers() const;
+
+	using Job = std::function<void()>;
+	///Collects jobs which prepare brokers for the cycle
+	/**
+	 * There is one job per broker. The job resets the broker and fetches status of markets
+	 * of all traders of that broker (one exchange per broker). Jobs hold their brokers, so
+	 * they can run without the lock of the Traders and in parallel.
+	 */
+	std::vector<Job> prepareBrokers() const;
+	///Performs traders of given markets out of the cycle
+	/**
+	 * Used to wake up traders when the broker notifies about an event. Brokers of the
+	 * traders are reset first, so the traders don't see cached data
+	 *
+	 * @param markets list of markets (broker, pair)
+	 */
+	void wakeupTraders(const std::vector<std::pair<std::string, std::string> > &markets) const;
+
+	using NotifyFn = std::function<void(const std::string_view &broker, const std::string_view &event, const std::string_view &pair)>;
+	///Registers the function to all brokers which are able to send notifications
+	void listenBrokers(NotifyFn &&fn);
 	SharedObject<NamedMTrader> find(json::StrViewA id) const;
 	PWalletDB walletDB;
 
@@ -8,7 +8,11 @@
 
 #include "webcfg.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <random>
+#include <thread>
 #include <imtjson/array.h>
 #include <imtjson/object.h>
 #include <imtjson/string.h>
@@ -43,6 +47,7 @@ NamedEnum<WebCfg::Command> WebCfg::strCommand({
 	{WebCfg::logout_commit, "logout_commit"},
 	{WebCfg::editor, "editor"},
 	{WebCfg::backtest, "backtest"},
+	{WebCfg::backtest_sweep, "backtest_sweep"},
 	{WebCfg::spread, "spread"},
 	{WebCfg::strategy, "strategy"},
 	{WebCfg::upload_prices, "upload_prices"},
@@ -93,6 +98,7 @@ bool WebCfg::operator ()(const simpleServer::HTTPRequest &req,
 		case logout_commit: return reqLogout(req,true);
 		case editor: return reqEditor(req);
 		case backtest: return reqBacktest(req);
+		case backtest_sweep: return reqBacktestSweep(req);
 		case spread: return reqSpread(req);
 		case strategy: return reqStrategy(req);
 		case upload_prices: return reqUploadPrices(req);
@@ -191,7 +197,8 @@ bool WebCfg::reqConfig(simpleServer::HTTPRequest req)  {
 					});
 				});
 				dispatch([rpt = traders.lock_shared()->rpt]()mutable{
-					rpt.lock()->genReport();
+					auto deltas = rpt.lock()->genReport();
+					Report::sendDeltas(std::move(deltas));
 				});
 
 
@@ -853,7 +860,8 @@ bool WebCfg::reqStop(simpleServer::HTTPRequest req)  {
 		auto tr = inf.second;
 		tr.lock()->perform(true);
 	});
-	trl->rpt.lock()->genReport();
+	auto deltas = trl->rpt.lock()->genReport();
+	Report::sendDeltas(std::move(deltas));
 	trl->resetBrokers();
 	req.sendResponse(std::move(hdr), "true");
 
@@ -1001,166 +1009,501 @@ static Value btevent_liquidation("liquidation");
 static Value btevent_no_balance("no_balance");
 static Value btevent_accept_loss("accept_loss");
 
+static BTPriceSource backtestPriceSource(const WebCfg::BacktestCacheSubj &trades, bool inv, bool rev, double init_price, std::uint64_t start_date) {
+	const auto &prices = trades.prices;
+	double mlt = 1.0;
+	double avg = std::accumulate(prices.begin(), prices.end(),0.0,[](double a, const BTPrice &b){return a + b.price;})/prices.size();
+	if (init_price && !prices.empty()) {
+		double fv = prices[rev?prices.size()-1:0].price;
+		if (inv) fv = 2*avg - fv;
+		if (trades.minfo.invert_price) {
+			mlt = (1.0/init_price)/fv;
+		} else {
+			mlt = init_price/fv;
+		}
+	}
+
+	BTPriceSource source = [&prices, rev, mlt, start_date, pos = std::size_t(0)]() mutable {
+		std::optional<BTPrice> x;
+		auto sz = prices.size();
+		while (pos < sz && prices[pos].time < start_date) ++pos;
+		if (pos < sz) {
+			x=BTPrice {prices[pos].time,prices[rev?sz-pos-1:pos].price*mlt};
+			++pos;
+		};
+		return x;
+	};
+
+	if (inv) {
+		source = [src = std::move(source),avg,mlt](){
+			auto r = src();
+			if (r.has_value()) r->price = 2*avg*mlt - r->price;
+			return r;
+		};
+	}
+	return source;
+}
+
+///Runs backtest by selected engine
+/**
+ * Engine "mtrader" runs the full trader against simulated broker. Default engine
+ * runs simplified cycle, which is much faster
+ */
+static void runBacktest(StrViewA engine, const MTrader_Config &cfg, BTPriceSource &&source,
+		const IStockApi::MarketInfo &minfo, std::optional<double> init_pos, double balance, bool negbal,
+		const BTDumpFilter &dumpFilter, const BTOutput &output) {
+	if (engine == "mtrader") {
+		backtest_mtrader(cfg, std::move(source), minfo, init_pos, balance, negbal, dumpFilter, output);
+	} else {
+		backtest_cycle(cfg, std::move(source), minfo, init_pos, balance, negbal, dumpFilter, output);
+	}
+}
+
+static std::size_t backtestDataSize(const WebCfg::BacktestCacheSubj &data) {
+	return sizeof(data) + data.prices.size() * sizeof(BTPrice);
+}
+
+///Stores backtest data to the caches, returns shared snapshot
+static WebCfg::PBacktestData putBacktestData(SharedObject<WebCfg::State> &state, const std::string &id, WebCfg::BacktestCacheSubj &&data) {
+	auto snapshot = std::make_shared<const WebCfg::BacktestCacheSubj>(std::move(data));
+	PriceHistoryCache::Entry e;
+	e.prices = PriceHistory(snapshot->prices, snapshot->minfo.currency_step, snapshot->inverted);
+	e.minfo = snapshot->minfo;
+	e.reversed = snapshot->reversed;
+	e.inverted = snapshot->inverted;
+	auto lkst = state.lock();
+	lkst->backtest_cache.put(id, std::move(e));
+	lkst->backtest_snapshots.put(id, snapshot, backtestDataSize(*snapshot));
+	return snapshot;
+}
+
+///Retrieves backtest data from the caches, or from the trader's trades (and fills the caches)
+/**
+ * @return shared snapshot of the data, or nullptr if the trader doesn't exist
+ */
+static WebCfg::PBacktestData getBacktestData(const SharedObject<Traders> &trlist, SharedObject<WebCfg::State> &state, const std::string &id) {
+	auto snapshot = state.lock_shared()->backtest_snapshots.get(id);
+	if (snapshot != nullptr) return snapshot;
+
+	auto e = state.lock()->backtest_cache.get(id);
+	if (e.has_value()) {
+		auto data = std::make_shared<WebCfg::BacktestCacheSubj>();
+		data->prices = e->prices.decode();
+		data->minfo = e->minfo;
+		data->reversed = e->reversed;
+		data->inverted = e->inverted;
+		state.lock_shared()->backtest_snapshots.put(id, data, backtestDataSize(*data));
+		return data;
+	}
+
+	auto tr = trlist.lock_shared()->find(id).lock_shared();
+	if (tr == nullptr) return nullptr;
+
+	const auto &tradeHist = tr->getTrades();
+	WebCfg::BacktestCacheSubj trs;
+	std::transform(tradeHist.begin(),tradeHist.end(),
+			std::back_insert_iterator(trs.prices),[](const IStatSvc::TradeRecord &r) {
+		return BTPrice{r.time, r.price};
+	});
+	trs.minfo = tr->getMarketInfo();
+	trs.inverted = false;
+	trs.reversed = false;
+	tr.release();
+
+	return putBacktestData(state, id, std::move(trs));
+}
+
+static Value btEventToJSON(BTEvent ev) {
+	switch (ev) {
+	default: return btevent_no_event;
+	case BTEvent::accept_loss: return btevent_accept_loss;
+	case BTEvent::liquidation: return btevent_liquidation;
+	case BTEvent::margin_call: return btevent_margin_call;
+	case BTEvent::no_balance: return btevent_no_balance;
+	}
+}
+
+static Value btSummaryToJSON(const BTSummary &s) {
+	return Object
+		("npl", s.norm_profit)
+		("npla", s.norm_profit_total)
+		("pl", s.pl)
+		("ps", s.pos)
+		("dd", s.max_drawdown)
+		("trades", s.trades)
+		("steps", s.steps)
+		("events", Object
+				("margin_call", s.margin_calls)
+				("liquidation", s.liquidations)
+				("no_balance", s.no_balance)
+				("accept_loss", s.accept_loss));
+}
+
+struct BTStep {
+	std::size_t index;
+	BTTrade trade;
+};
+
+template<typename T>
+static void appendColumn(std::string &out, const std::vector<BTStep> &steps, T (*fn)(const BTTrade &)) {
+	for (const auto &s: steps) {
+		T v = fn(s.trade);
+		out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+	}
+}
+
+///Serializes backtest to compact columnar binary format
+/**
+ * Format (host byte order):
+ * - "MMBT", uint32 version(1), uint32 count
+ * - columns (struct of arrays, each has count items):
+ *   uint64 ix, uint64 tm, double pr, double sz, double ps, double pl,
+ *   double npl, double npla, double np, double op, uint8 event
+ * - uint32 length + JSON object of strategy dumps {"<ix>":{...}} (length is 0 if there are no dumps)
+ */
+static std::string backtestToBinary(const std::vector<BTStep> &steps) {
+	std::string out("MMBT");
+	std::uint32_t hdr[2] = {1, static_cast<std::uint32_t>(steps.size())};
+	out.append(reinterpret_cast<const char *>(hdr), sizeof(hdr));
+	for (const auto &s: steps) {
+		std::uint64_t ix = s.index;
+		out.append(reinterpret_cast<const char *>(&ix), sizeof(ix));
+	}
+	appendColumn<std::uint64_t>(out, steps, [](const BTTrade &t) {return t.price.time;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.price.price;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.size;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.pos;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.pl;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.norm_profit;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.norm_profit_total;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.neutral_price;});
+	appendColumn<double>(out, steps, [](const BTTrade &t) {return t.open_price;});
+	appendColumn<std::uint8_t>(out, steps, [](const BTTrade &t) {return static_cast<std::uint8_t>(t.event);});
+	Object dumps;
+	bool has_dumps = false;
+	for (const auto &s: steps) {
+		if (s.trade.info.defined()) {
+			dumps.set(std::to_string(s.index), s.trade.info);
+			has_dumps = true;
+		}
+	}
+	std::string dumpstr;
+	if (has_dumps) dumpstr = Value(dumps).stringify().str();
+	std::uint32_t len = dumpstr.length();
+	out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+	out.append(dumpstr);
+	return out;
+}
+
 bool WebCfg::reqBacktest(simpleServer::HTTPRequest req)  {
 	if (!req.allowMethods({"POST","DELETE"})) return true;
 	if (req.getMethod() == "DELETE") {
 		auto lkst = state.lock();
 		lkst->backtest_cache.clear();
+		lkst->backtest_snapshots.clear();
 		lkst->prices_cache.clear();
 		lkst->spread_cache.clear();
+		lkst->spread_result_cache.clear();
 		req.sendResponse("application/json","true");
 		return true;
 	} else  {
 		req.readBodyAsync(50000,[&trlist = this->trlist,state =  this->state](simpleServer::HTTPRequest req)mutable{
 			try {
-				Value orgdata = Value::fromString(StrViewA(BinaryView(req.getUserBuffer())));
-				Value id = orgdata["id"];
-
-				Value reverse=orgdata["reverse"];
-				Value invert=orgdata["invert"];
-
-
-				auto process=[=](Traders &trlist, const BacktestCache::Subj &trades, bool inv, bool rev) {
-
-					Value data = orgdata;
-					Value config = data["config"];
-					Value init_pos = data["init_pos"];
-					Value balance = data["balance"];
-					Value init_price = data["init_price"];
-					Value fill_atprice= data["fill_atprice"];
-					Value negbal= data["neg_bal"];
-
-					std::uint64_t start_date=data["start_date"].getUIntLong();
-
-					MTrader_Config mconfig;
-					mconfig.loadConfig(config,false);
-					std::optional<double> m_init_pos;
-					if (init_pos.hasValue()) m_init_pos = init_pos.getNumber();
-
-					auto piter = trades.prices.begin();
-					auto pend = trades.prices.end();
-					double mlt = 1.0;
-					double avg = std::accumulate(trades.prices.begin(), trades.prices.end(),0.0,[](double a, const BTPrice &b){return a + b.price;})/trades.prices.size();
-					double ip = init_price.getNumber();
-					if (ip && !trades.prices.empty()) {
-						double fv = trades.prices[rev?trades.prices.size()-1:0].price;
-						if (inv) fv = 2*avg - fv;
-						if (trades.minfo.invert_price) {
-							mlt = (1.0/ip)/fv;
-						} else {
-							mlt = ip/fv;
-						}
+				Value data = Value::fromString(StrViewA(BinaryView(req.getUserBuffer())));
+				Value id = data["id"];
+				Value config = data["config"];
+				Value init_pos = data["init_pos"];
+				Value balance = data["balance"];
+				Value init_price = data["init_price"];
+				Value negbal= data["neg_bal"];
+				std::uint64_t start_date=data["start_date"].getUIntLong();
+
+				PBacktestData trades = getBacktestData(trlist, state, id.toString().str());
+				if (trades == nullptr) {
+					req.sendErrorPage(404);
+					return;
+				}
+				bool inv = trades->inverted != data["invert"].getBool();
+				bool rev = trades->reversed != data["reverse"].getBool();
+
+				MTrader_Config mconfig;
+				mconfig.loadConfig(config,false);
+				std::optional<double> m_init_pos;
+				if (init_pos.hasValue()) m_init_pos = init_pos.getNumber();
+
+				StrViewA mode = data["mode"].getValueOrDefault("full");
+				bool full = mode == "full";
+				bool summary = mode == "summary";
+				bool binary = mode == "binary";
+				std::size_t decimate = std::max<std::size_t>(1,data["decimate"].getUInt());
+				std::vector<std::size_t> dumps;
+				for (Value v: data["dump"]) dumps.push_back(v.getUInt());
+				std::sort(dumps.begin(), dumps.end());
+
+				BTDumpFilter dumpFilter;
+				if (full) dumpFilter = [](std::size_t) {return true;};
+				else dumpFilter = [&](std::size_t idx) {return std::binary_search(dumps.begin(), dumps.end(), idx);};
+
+				BTSummary sum;
+				std::vector<BTStep> rs;
+				std::optional<BTStep> last;
+				std::size_t index = 0;
+				runBacktest(data["engine"].getString(), mconfig,
+						backtestPriceSource(*trades, inv, rev, init_price.getNumber(), start_date),
+						trades->minfo,m_init_pos, balance.getNumber(), negbal.getBool(),
+						dumpFilter, [&](const BTTrade &t) {
+					sum.add(t);
+					if (summary) {
+						if (t.info.defined()) rs.push_back({index, t});
+					} else if (index % decimate == 0 || t.event != BTEvent::no_event || t.info.defined()) {
+						rs.push_back({index, t});
+						last.reset();
+					} else {
+						last = BTStep{index, t};
 					}
+					index++;
+				});
+				//always include last step
+				if (last.has_value()) rs.push_back(*last);
 
-					BTPriceSource source;
-					if (rev) {
-						auto priter = trades.prices.rbegin();
+				if (binary) {
+					req.sendResponse("application/octet-stream", StrViewA(backtestToBinary(rs)));
+					return;
+				}
+				if (summary) {
+					Value result = btSummaryToJSON(sum).replace("info", Value(json::object, rs.begin(), rs.end(), [](const BTStep &x) {
+						return Value(std::to_string(x.index), x.trade.info);
+					}));
+					req.sendResponse("application/json",result.stringify());
+					return;
+				}
 
-						source = [&, priter]() mutable {
-							std::optional<BTPrice> x;
-							while (piter != pend && piter->time < start_date) {++piter; ++priter;}
-							if (piter != pend) {
-								x=BTPrice {piter->time,priter->price*mlt};
-								++piter;
-								++priter;
-							};
-							return x;
-						};
+				Value result (json::array, rs.begin(), rs.end(), [&](const BTStep &s) {
+					const BTTrade &x = s.trade;
+					Object item;
+					item("np",x.neutral_price)
+						("op",x.open_price)
+						("na",x.norm_accum)
+						("npl",x.norm_profit)
+						("npla",x.norm_profit_total)
+						("pl",x.pl)
+						("ps",x.pos)
+						("pr",x.price.price)
+						("tm",x.price.time)
+						("info",x.info)
+						("sz",x.size)
+						("event", btEventToJSON(x.event));
+					if (!full) item("ix", s.index);
+					return Value(item);
+				});
+				String resstr = result.toString();
+				req.sendResponse("application/json",resstr.str());
+			} catch (std::exception &e) {
+				req.sendErrorPage(400,"", e.what());
+			}
 
+		});
+		return true;
+	}
+}
 
-					} else {
-						source = [&]{
-							std::optional<BTPrice> x;
-							while (piter != pend && piter->time < start_date) ++piter;
-							if (piter != pend) {
-								x=BTPrice {piter->time,piter->price*mlt};
-								++piter;
-							};
-							return x;
-						};
-					}
+///Replaces value in the config specified by path (keys are separated by dot)
+static Value replaceConfigPath(Value cfg, StrViewA path, Value newval) {
+	auto sep = path.indexOf(".");
+	if (sep == StrViewA::npos) return cfg.getValueOrDefault(Value(json::object)).replace(path, newval);
+	StrViewA key = path.substr(0,sep);
+	Value sub = cfg[key];
+	return cfg.getValueOrDefault(Value(json::object)).replace(key, replaceConfigPath(sub, path.substr(sep+1), newval));
+}
 
-					if (inv) {
-						source = [src = std::move(source),avg,mlt](){
-							auto r = src();
-							if (r.has_value()) r->price = 2*avg*mlt - r->price;
-							return r;
-						};
-					}
+///Generates list of values from parameter specification
+/**
+ * @param spec array of values or object {"from":..., "to":..., "step":...}
+ */
+static std::vector<Value> sweepValues(Value spec) {
+	std::vector<Value> res;
+	if (spec.type() == json::array) {
+		for (Value v: spec) res.push_back(v);
+	} else if (spec.type() == json::object) {
+		double from = spec["from"].getNumber();
+		double to = spec["to"].getNumber();
+		double step = spec["step"].getNumber();
+		if (step <= 0 || to < from) throw std::runtime_error("Invalid range (from, to, step)");
+		std::size_t cnt = static_cast<std::size_t>(std::floor((to - from)/step + 1e-9))+1;
+		if (cnt > WebCfg::max_sweep_runs) throw std::runtime_error("Too many values in range");
+		for (std::size_t i = 0; i < cnt; i++) res.push_back(from + step * i);
+	} else {
+		res.push_back(spec);
+	}
+	return res;
+}
 
-					BTTrades rs = backtest_cycle(mconfig,std::move(source),
-							trades.minfo,m_init_pos, balance.getNumber(), negbal.getBool());
+///Pool of threads which run backtests of sweeps
+/**
+ * The pool is shared by all sweeps, so count of threads is limited regardless of count
+ * of requests. Backtests don't run on the scheduler, so they don't block trading
+ */
+static Worker sweepWorker() {
+	static Worker wrk = Worker::create(std::max(1U, std::thread::hardware_concurrency()));
+	return wrk;
+}
 
+namespace {
 
+///State of one parameter sweep
+/**
+ * Each run is a separate task of the sweepWorker(). The task which finishes the last
+ * run sends the response
+ */
+struct BacktestSweep {
+	struct Run {
+		Value params;
+		BTSummary summary;
+		std::string error;
+	};
 
-					Value result (json::array, rs.begin(), rs.end(), [](const BTTrade &x) {
-						Value event;
-						switch (x.event) {
-						default: event = btevent_no_event;break;
-						case BTEvent::accept_loss: event = btevent_accept_loss;break;
-						case BTEvent::liquidation: event = btevent_liquidation;break;
-						case BTEvent::margin_call: event = btevent_margin_call;break;
-						case BTEvent::no_balance: event = btevent_no_balance;break;
-						}
-						return Object
-								("np",x.neutral_price)
-								("op",x.open_price)
-								("na",x.norm_accum)
-								("npl",x.norm_profit)
-								("npla",x.norm_profit_total)
-								("pl",x.pl)
-								("ps",x.pos)
-								("pr",x.price.price)
-								("tm",x.price.time)
-								("info",x.info)
-								("sz",x.size)
-								("event", event);
-					});
-					String resstr = result.toString();
-					req.sendResponse("application/json",resstr.str());
-				};
+	simpleServer::HTTPRequest req;
+	WebCfg::PBacktestData trades;
+	Value config;
+	std::vector<std::string> names;
+	std::vector<std::vector<Value> > values;
+	std::string engine;
+	std::string sort_by;
+	std::size_t limit;
+	std::optional<double> init_pos;
+	double balance;
+	double init_price;
+	bool negbal;
+	bool inv;
+	bool rev;
+	std::uint64_t start_date;
+	std::vector<Run> runs;
+	std::atomic<std::size_t> remain;
+
+	void runOne(std::size_t idx);
+	void finish();
+};
 
+}
 
+void BacktestSweep::runOne(std::size_t idx) {
+	Run &r = runs[idx];
+	Value cfg = config;
+	Object prm;
+	std::size_t k = idx;
+	for (std::size_t i = 0; i < names.size(); i++) {
+		const auto &vals = values[i];
+		Value v = vals[k % vals.size()];
+		k /= vals.size();
+		cfg = replaceConfigPath(cfg, names[i], v);
+		prm.set(names[i], v);
+	}
+	r.params = prm;
+	try {
+		MTrader_Config mconfig;
+		mconfig.loadConfig(cfg,false);
+		runBacktest(engine, mconfig,
+				backtestPriceSource(*trades, inv, rev, init_price, start_date),
+				trades->minfo,init_pos, balance, negbal,
+				[](std::size_t) {return false;},
+				[&](const BTTrade &t) {r.summary.add(t);});
+	} catch (std::exception &e) {
+		r.error = e.what();
+	}
+	if (--remain == 0) finish();
+}
 
-				auto lkst = state.lock_shared();
-				if (lkst->backtest_cache.available(id.toString().str())) {
-					auto t = lkst->backtest_cache.getSubject();
-					bool inv = t.inverted != invert.getBool();
-					bool rev = t.reversed != reverse.getBool();
-					process(*trlist.lock(), t, inv, rev);
-				} else {
-					lkst.release();
-						try {
-							auto tr = trlist.lock_shared()->find(id.getString()).lock_shared();
-							if (tr == nullptr) {
-								req.sendErrorPage(404);
-								return;
-							}
+void BacktestSweep::finish() {
+	try {
+		auto rankValue = [&](const BTSummary &s) {
+			if (sort_by == "npl") return s.norm_profit;
+			if (sort_by == "pl") return s.pl;
+			if (sort_by == "dd") return -s.max_drawdown;
+			return s.norm_profit_total;
+		};
+		std::vector<const Run *> ranked;
+		std::size_t failed = 0;
+		for (const auto &r: runs) {
+			if (r.error.empty()) ranked.push_back(&r); else failed++;
+		}
+		std::stable_sort(ranked.begin(), ranked.end(), [&](const Run *a, const Run *b) {
+			return rankValue(a->summary) > rankValue(b->summary);
+		});
+		if (ranked.size() > limit) ranked.resize(limit);
 
-							const auto &tradeHist = tr->getTrades();
-							BacktestCacheSubj trs;
-							std::transform(tradeHist.begin(),tradeHist.end(),
-									std::back_insert_iterator(trs.prices),[](const IStatSvc::TradeRecord &r) {
-								return BTPrice{r.time, r.price};
-							});
-							trs.minfo = tr->getMarketInfo();
-							trs.inverted = false;
-							trs.reversed = false;
-							tr.release();
+		Array errors;
+		for (const auto &r: runs) {
+			if (!r.error.empty()) errors.push_back(Object("params", r.params)("error", r.error));
+		}
 
-							state.lock()->backtest_cache = BacktestCache(trs, id.toString().str());
-							process(*trlist.lock(), trs, invert.getBool(), reverse.getBool());
-						} catch (std::exception &e) {
-							req.sendErrorPage(400,"", e.what());
-						}
-				}
-			} catch (std::exception &e) {
-				req.sendErrorPage(400,"", e.what());
+		Value result = Object
+			("total", runs.size())
+			("failed", failed)
+			("results", Value(json::array, ranked.begin(), ranked.end(), [](const Run *r) {
+				return btSummaryToJSON(r->summary).replace("params", r->params);
+			}))
+			("errors", errors);
+		req.sendResponse("application/json",result.stringify());
+	} catch (std::exception &e) {
+		req.sendErrorPage(400,"", e.what());
+	}
+}
+
+bool WebCfg::reqBacktestSweep(simpleServer::HTTPRequest req)  {
+	if (!req.allowMethods({"POST"})) return true;
+	req.readBodyAsync(50000,[trlist = this->trlist,state =  this->state](simpleServer::HTTPRequest req)mutable{
+		try {
+			Value data = Value::fromString(StrViewA(BinaryView(req.getUserBuffer())));
+			Value id = data["id"];
+			Value init_pos = data["init_pos"];
+
+			PBacktestData trades = getBacktestData(trlist, state, id.toString().str());
+			if (trades == nullptr) {
+				req.sendErrorPage(404);
+				return;
 			}
 
-		});
-		return true;
-	}
+			auto sweep = std::make_shared<BacktestSweep>();
+			sweep->trades = trades;
+			sweep->config = data["config"];
+			sweep->balance = data["balance"].getNumber();
+			sweep->init_price = data["init_price"].getNumber();
+			sweep->negbal = data["neg_bal"].getBool();
+			sweep->start_date = data["start_date"].getUIntLong();
+			sweep->engine = data["engine"].getString();
+			sweep->sort_by = data["sort"].getValueOrDefault("npla");
+			sweep->limit = data["limit"].getUInt();
+			if (sweep->limit == 0) sweep->limit = 100;
+			sweep->inv = trades->inverted != data["invert"].getBool();
+			sweep->rev = trades->reversed != data["reverse"].getBool();
+			if (init_pos.hasValue()) sweep->init_pos = init_pos.getNumber();
+
+			//build grid
+			std::size_t total = 1;
+			for (Value p: data["params"]) {
+				StrViewA key = p.getKey();
+				sweep->names.push_back(std::string(key.data, key.length));
+				sweep->values.push_back(sweepValues(p));
+				total *= sweep->values.back().size();
+				if (total == 0 || total > max_sweep_runs) {
+					req.sendErrorPage(400,"", "Too many combinations");
+					return;
+				}
+			}
+			sweep->runs.resize(total);
+			sweep->remain = total;
+			sweep->req = req;
+
+			//backtests run on the shared pool, the last run sends the response
+			Worker wrk = sweepWorker();
+			for (std::size_t i = 0; i < total; i++) {
+				wrk >> [sweep, i] {sweep->runOne(i);};
+			}
+		} catch (std::exception &e) {
+			req.sendErrorPage(400,"", e.what());
+		}
+	});
+	return true;
 }
 
 template<typename Iter>
@@ -1216,32 +1559,39 @@ bool WebCfg::reqSpread(simpleServer::HTTPRequest req)  {
 						});
 					}))}
 				);
-				req.sendResponse("application/json", out.stringify());
+				return std::make_shared<const std::string>(out.stringify().str());
 			};
 
-			auto lkst = state.lock_shared();
-			if (lkst->spread_cache.available(id.toString().str())) {
-				auto t = lkst->spread_cache.getSubject();
-				process(t);
-			} else {
-				lkst.release();
-				try {
-					auto tr = trlist.lock_shared()->find(id.getString()).lock_shared();
-					if (tr == nullptr) {
-						req.sendErrorPage(404);
+			std::string key = id.toString().str();
+			std::string result_key = key + "\n" + args.stringify().str();
+			auto result = state.lock_shared()->spread_result_cache.get(result_key);
+			if (result == nullptr) {
+				PSpreadData data = state.lock_shared()->spread_cache.get(key);
+				if (data == nullptr) {
+					try {
+						auto tr = trlist.lock_shared()->find(id.getString()).lock_shared();
+						if (tr == nullptr) {
+							req.sendErrorPage(404);
+							return;
+						}
+						SpreadCacheItem x;
+						x.chart = tr->getChart();
+						x.invert_price = tr->getMarketInfo().invert_price;
+						tr.release();
+						data = std::make_shared<const SpreadCacheItem>(std::move(x));
+						auto lkst = state.lock_shared();
+						lkst->spread_cache.put(key, data, sizeof(SpreadCacheItem) + data->chart.size() * sizeof(MTrader::ChartItem));
+						//results calculated from previous chart are no longer valid
+						lkst->spread_result_cache.erasePrefix(key + "\n");
+					} catch (std::exception &e) {
+						req.sendErrorPage(400,"", e.what());
 						return;
 					}
-					SpreadCacheItem x;
-					x.chart = tr->getChart();
-					x.invert_price = tr->getMarketInfo().invert_price;
-					tr.release();
-					state.lock()->spread_cache= SpreadCache(x, id.toString().str());
-					process(x);
-				} catch (std::exception &e) {
-					req.sendErrorPage(400,"", e.what());
 				}
-
+				result = process(*data);
+				state.lock_shared()->spread_result_cache.put(result_key, result, result->size());
 			}
+			req.sendResponse("application/json", StrViewA(*result));
 
 
 		} catch (std::exception &e) {
@@ -1271,7 +1621,7 @@ bool WebCfg::reqUploadPrices(simpleServer::HTTPRequest req)  {
 
 			if (prices.getString() == "internal") {
 				auto lkst = state.lock();
-				lkst->prices_cache.clear();
+				lkst->prices_cache.erase(id.toString().str());
 				lkst->upload_progress = 0;
 			} else if (prices.getString() == "update") {
 				auto lkst = state.lock();
@@ -1312,7 +1662,8 @@ bool WebCfg::reqUploadPrices(simpleServer::HTTPRequest req)  {
 
 				tr.release();
 				auto lkst = state.lock();
-				lkst->prices_cache = PricesCache(chart, id.toString().str());
+				std::size_t sz = chart.size() * sizeof(double);
+				lkst->prices_cache.put(id.toString().str(), std::make_shared<const std::vector<double> >(std::move(chart)), sz);
 				lkst->upload_progress = 0;
 			}
 			req.sendResponse("application/json", "0");
@@ -1353,9 +1704,8 @@ bool WebCfg::reqUploadTrades(simpleServer::HTTPRequest req)  {
 				bt.reversed = false;
 				bt.inverted = false;
 				tr.release();
-				auto lkst = state.lock();
-				lkst->upload_progress = -1;
-				lkst->backtest_cache = BacktestCache(bt, id.toString().str());
+				putBacktestData(state, id.toString().str(), std::move(bt));
+				state.lock()->upload_progress = -1;
 				req.sendResponse("application/json", "true");
 			} catch (std::exception &e) {
 				req.sendErrorPage(400,"",e.what());
@@ -1391,7 +1741,8 @@ bool WebCfg::generateTrades(const SharedObject<Traders> &trlist, PState state, j
 
 		std::function<std::optional<MTrader::ChartItem>()> source;
 		lkst->upload_progress = 0;
-		if (!lkst->prices_cache.available(id.getString())) {
+		PPricesData prc = lkst->prices_cache.get(id.toString().str());
+		if (prc == nullptr) {
 			auto chart = tr->getChart();
 			avg = std::accumulate(chart.begin(), chart.end(), 0.0,[](double a, const MTrader::ChartItem &b){return a + b.last;})/chart.size();
 			source = [=,pos = std::size_t(0),sz = chart.size() ]() mutable {
@@ -1403,15 +1754,14 @@ bool WebCfg::generateTrades(const SharedObject<Traders> &trlist, PState state, j
 				return std::optional<MTrader::ChartItem>(chart[ps]);
 			};
 		} else {
-			auto prc = lkst->prices_cache.getSubject();
-			avg = std::accumulate(prc.begin(), prc.end(), 0.0,[](double a, double b){return a + b;})/prc.size();
+			avg = std::accumulate(prc->begin(), prc->end(), 0.0,[](double a, double b){return a + b;})/prc->size();
 			auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-			source = [pos = std::size_t(0), sz = prc.size(), prc = std::move(prc), state , now,rev]() mutable {
+			source = [pos = std::size_t(0), sz = prc->size(), prc, state , now,rev]() mutable {
 				if (state.lock_shared()->cancel_upload || pos >= sz) {
 					return std::optional<MTrader::ChartItem>();
 				}
 				auto ps = rev?sz-pos-1:pos; ++pos;
-				double p = prc[ps];
+				double p = (*prc)[ps];
 				state.lock()->upload_progress = (pos * 100)/sz;
 				return std::optional<MTrader::ChartItem>(MTrader::ChartItem{static_cast<uint64_t>(now - (sz - pos)*60000),p,p,p});
 			};
@@ -1444,9 +1794,8 @@ bool WebCfg::generateTrades(const SharedObject<Traders> &trlist, PState state, j
 		bt.minfo = tr->getMarketInfo();
 		bt.reversed = rev;
 		bt.inverted = invert.getBool();
-		lkst = state.lock();
-		lkst->upload_progress = -1;
-		lkst->backtest_cache = BacktestCache(bt, id.toString().str());
+		putBacktestData(state, id.toString().str(), std::move(bt));
+		state.lock()->upload_progress = -1;
 		return true;
 	} catch (std::exception &e) {
 		logError("Error: $1", e.what());
@@ -19,6 +19,8 @@
 #include "istockapi.h"
 #include "authmapper.h"
 #include "backtest.h"
+#include "price_history.h"
+#include "shared_cache.h"
 #include "traders.h"
 
 
@@ -28,29 +30,6 @@ public:
 	using Action = std::function<void()>;
 	using Dispatch = ondra_shared::shared_function<void(Action &&)>;
 
-	template<typename T>
-	class Cache {
-	public:
-		using Subj = T;
-
-		Cache() {}
-		Cache(const T &t, std::string name)
-			:t(t),name(name) {}
-
-		const T getSubject() const {return t;}
-		bool available(const std::string_view &name) const {
-			return name == this->name;
-		}
-		void clear() {
-			name.clear();
-			t = T();
-		}
-
-	protected:
-		T t;
-		std::string name;
-	};
-
 	struct SpreadCacheItem {
 		MTrader::Chart chart;
 		bool invert_price;
@@ -63,9 +42,15 @@ public:
 		bool inverted;
 	};
 
-	using BacktestCache = Cache<BacktestCacheSubj>;
-	using SpreadCache = Cache<SpreadCacheItem>;
-	using PricesCache = Cache<std::vector<double> >;
+	using PBacktestData = std::shared_ptr<const BacktestCacheSubj>;
+	using PSpreadData = std::shared_ptr<const SpreadCacheItem>;
+	using PPricesData = std::shared_ptr<const std::vector<double> >;
+
+	///Size limits of the caches in bytes
+	static const std::size_t backtest_cache_limit = 128*1024*1024;
+	static const std::size_t spread_cache_limit = 128*1024*1024;
+	static const std::size_t prices_cache_limit = 64*1024*1024;
+	static const std::size_t spread_result_cache_limit = 16*1024*1024;
 
 	class State : public ondra_shared::RefCntObj{
 	public:
@@ -74,9 +59,16 @@ public:
 		ondra_shared::RefCntPtr<AuthUserList> users, admins;
 		std::vector<std::string> traderNames;
 		json::Value broker_config;
-		BacktestCache backtest_cache;
-		SpreadCache spread_cache;
-		PricesCache prices_cache;
+		///compressed price histories (can spill to disk), needs exclusive lock
+		PriceHistoryCache backtest_cache;
+		///decoded price histories shared by running backtests (MT safe)
+		SharedCache<BacktestCacheSubj> backtest_snapshots{backtest_cache_limit};
+		///charts of traders (MT safe)
+		SharedCache<SpreadCacheItem> spread_cache{spread_cache_limit};
+		///uploaded prices (MT safe)
+		SharedCache<std::vector<double> > prices_cache{prices_cache_limit};
+		///results of spread visualization keyed by trader and parameters (MT safe)
+		SharedCache<std::string> spread_result_cache{spread_result_cache_limit};
 		int upload_progress=-1;
 		bool cancel_upload = false;
 
@@ -123,6 +115,7 @@ public:
 		editor,
 		login,
 		backtest,
+		backtest_sweep,
 		spread,
 		strategy,
 		upload_prices,
@@ -137,6 +130,9 @@ public:
 
 	static json::NamedEnum<Command> strCommand;
 
+	///Maximum count of backtests in single parameter sweep
+	static const std::size_t max_sweep_runs = 1000;
+
 
 protected:
 	bool reqConfig(simpleServer::HTTPRequest req);
@@ -149,6 +145,7 @@ protected:
 	bool reqBrokerSpec(simpleServer::HTTPRequest req, ondra_shared::StrViewA rest, PStockApi api, ondra_shared::StrViewA broker_name);
 	bool reqEditor(simpleServer::HTTPRequest req);
 	bool reqBacktest(simpleServer::HTTPRequest req);
+	bool reqBacktestSweep(simpleServer::HTTPRequest req);
 	bool reqSpread(simpleServer::HTTPRequest req);
 	bool reqUploadPrices(simpleServer::HTTPRequest req);
 	bool reqUploadTrades(simpleServer::HTTPRequest req);
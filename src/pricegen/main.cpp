@@ -0,0 +1,107 @@
+/*
+ * main.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include <cstdlib>
+#include <experimental/filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "price_generator.h"
+
+using namespace std::experimental::filesystem;
+
+static const unsigned int year_minutes = 525600;
+
+static void usage() {
+	std::cerr << "Usage:\n\n"
+			"pricegen <model> <output> [-s seed] [-n minutes] [-p price] [-v volatility] [-i source.csv]\n"
+			"\tgenerates one series. Model is one of: gbm, jump, regime, bootstrap\n"
+			"\t(bootstrap requires -i)\n\n"
+			"pricegen dataset <dir> [backtest_dir] [seed]\n"
+			"\tbuilds benchmark dataset - each model with low, medium and high volatility\n"
+			"\tand bootstrap of each csv file in the backtest_dir. One year per series\n";
+}
+
+///start time of generated series (2020-01-01), fixed, so same seed generates same file
+static const std::uint64_t start_time = 1577836800000ULL;
+
+static void generate(const IPriceGenerator &gen, std::uint64_t seed, std::size_t minutes, double price, const std::string &out) {
+	PriceSeries s;
+	s.start_time = start_time;
+	s.prices = gen.generate(price, minutes, seed, IPriceGenerator::minutes_per_year);
+	s.saveFile(out);
+	std::cout << out << ": " << s.prices.size() << " prices, last " << s.prices.back() << std::endl;
+}
+
+static int buildDataset(const std::string &dir, const std::string &bt_dir, std::uint64_t seed) {
+	create_directories(dir);
+	const struct {const char *name; double vol;} vols[] = {
+			{"low", 0.3},{"mid", 0.8},{"high", 1.5}
+	};
+	for (const char *model: {"gbm","jump","regime"}) {
+		for (const auto &v: vols) {
+			auto gen = createPriceGenerator(model, v.vol);
+			generate(*gen, seed, year_minutes, 100, dir + "/" + model + "_" + v.name + ".bin");
+		}
+	}
+	if (!bt_dir.empty()) {
+		for (const auto &entry: directory_iterator(bt_dir)) {
+			path p = entry.path();
+			if (p.extension() != ".csv") continue;
+			PriceSeries src = PriceSeries::loadCSVFile(p.string());
+			if (src.prices.size() < 2) continue;
+			BootstrapGenerator gen(src);
+			generate(gen, seed, year_minutes, src.prices[0], dir + "/bootstrap_" + p.stem().string() + ".bin");
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		usage();
+		return 1;
+	}
+	try {
+		std::string cmd = argv[1];
+		if (cmd == "dataset") {
+			std::string bt_dir = argc > 3?argv[3]:"";
+			std::uint64_t seed = argc > 4?std::strtoull(argv[4], nullptr, 10):1;
+			return buildDataset(argv[2], bt_dir, seed);
+		}
+
+		std::string out = argv[2];
+		std::uint64_t seed = 1;
+		std::size_t minutes = year_minutes;
+		double price = 100;
+		double volatility = 0.8;
+		std::string source;
+		for (int i = 3; i+1 < argc; i+=2) {
+			std::string opt = argv[i];
+			const char *val = argv[i+1];
+			if (opt == "-s") seed = std::strtoull(val, nullptr, 10);
+			else if (opt == "-n") minutes = std::strtoull(val, nullptr, 10);
+			else if (opt == "-p") price = std::strtod(val, nullptr);
+			else if (opt == "-v") volatility = std::strtod(val, nullptr);
+			else if (opt == "-i") source = val;
+			else {
+				usage();
+				return 1;
+			}
+		}
+		if (minutes == 0) throw std::runtime_error("Count of minutes (-n) must be greater than zero");
+		PriceSeries src;
+		if (!source.empty()) src = PriceSeries::loadCSVFile(source);
+		auto gen = createPriceGenerator(cmd, volatility, source.empty()?nullptr:&src);
+		generate(*gen, seed, minutes, price, out);
+		return 0;
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 2;
+	}
+}
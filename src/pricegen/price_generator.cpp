@@ -0,0 +1,133 @@
+/*
+ * price_generator.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "price_generator.h"
+
+#include <cmath>
+#include <stdexcept>
+
+double PriceGenRandom::normal() {
+	if (has_spare) {
+		has_spare = false;
+		return spare;
+	}
+	double u1 = uniform();
+	double u2 = uniform();
+	double r = std::sqrt(-2.0 * std::log(u1));
+	double a = 2.0 * M_PI * u2;
+	spare = r * std::sin(a);
+	has_spare = true;
+	return r * std::cos(a);
+}
+
+std::vector<double> GBMGenerator::generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year) const {
+	PriceGenRandom rnd(seed);
+	double dt = 1.0/steps_per_year;
+	double mu = (drift - volatility*volatility*0.5)*dt;
+	double sigma = volatility * std::sqrt(dt);
+	std::vector<double> res;
+	res.reserve(count);
+	double lp = std::log(start_price);
+	for (std::size_t i = 0; i < count; i++) {
+		res.push_back(std::exp(lp));
+		lp += mu + sigma * rnd.normal();
+	}
+	return res;
+}
+
+std::vector<double> JumpDiffusionGenerator::generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year) const {
+	PriceGenRandom rnd(seed);
+	double dt = 1.0/steps_per_year;
+	//compensation, so the jumps don't change expected drift
+	double k = std::exp(jump_mean + jump_stdev*jump_stdev*0.5) - 1.0;
+	double mu = (drift - volatility*volatility*0.5 - intensity*k)*dt;
+	double sigma = volatility * std::sqrt(dt);
+	//at most one jump per step - probability of more jumps is negligible for small steps
+	double jump_prob = intensity * dt;
+	std::vector<double> res;
+	res.reserve(count);
+	double lp = std::log(start_price);
+	for (std::size_t i = 0; i < count; i++) {
+		res.push_back(std::exp(lp));
+		lp += mu + sigma * rnd.normal();
+		if (rnd.uniform() < jump_prob) lp += jump_mean + jump_stdev * rnd.normal();
+	}
+	return res;
+}
+
+RegimeSwitchingGenerator::RegimeSwitchingGenerator(std::vector<Regime> regimes)
+	:regimes(std::move(regimes))
+{
+	if (this->regimes.empty()) throw std::runtime_error("RegimeSwitchingGenerator: no regimes");
+}
+
+std::vector<double> RegimeSwitchingGenerator::generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year) const {
+	PriceGenRandom rnd(seed);
+	double dt = 1.0/steps_per_year;
+	double sdt = std::sqrt(dt);
+	std::size_t cur = rnd.index(regimes.size());
+	std::vector<double> res;
+	res.reserve(count);
+	double lp = std::log(start_price);
+	for (std::size_t i = 0; i < count; i++) {
+		res.push_back(std::exp(lp));
+		const Regime &r = regimes[cur];
+		lp += (r.drift - r.volatility*r.volatility*0.5)*dt + r.volatility * sdt * rnd.normal();
+		if (regimes.size() > 1 && rnd.uniform() * r.duration < 1.0) {
+			std::size_t n = rnd.index(regimes.size()-1);
+			cur = n >= cur?n+1:n;
+		}
+	}
+	return res;
+}
+
+BootstrapGenerator::BootstrapGenerator(const PriceSeries &source, double block)
+	:block(std::max(block, 1.0))
+{
+	const auto &p = source.prices;
+	if (p.size() < 2) throw std::runtime_error("BootstrapGenerator: source is too short");
+	returns.reserve(p.size()-1);
+	for (std::size_t i = 1; i < p.size(); i++) returns.push_back(std::log(p[i]/p[i-1]));
+}
+
+std::vector<double> BootstrapGenerator::generate(double start_price, std::size_t count, std::uint64_t seed, double ) const {
+	PriceGenRandom rnd(seed);
+	std::size_t n = returns.size();
+	std::size_t pos = rnd.index(n);
+	std::vector<double> res;
+	res.reserve(count);
+	double lp = std::log(start_price);
+	for (std::size_t i = 0; i < count; i++) {
+		res.push_back(std::exp(lp));
+		lp += returns[pos];
+		if (rnd.uniform() * block < 1.0) pos = rnd.index(n);
+		else pos = (pos + 1) % n;
+	}
+	return res;
+}
+
+PPriceGenerator createPriceGenerator(const std::string &name, double volatility, const PriceSeries *source) {
+	if (name == "gbm") {
+		return std::make_unique<GBMGenerator>(0, volatility);
+	} else if (name == "jump") {
+		//diffusion carries 3/4 of the variance, jumps (12 per year) the rest
+		double jstdev = std::sqrt(volatility*volatility*0.25/12);
+		return std::make_unique<JumpDiffusionGenerator>(0, volatility*std::sqrt(0.75), 12, 0, jstdev);
+	} else if (name == "regime") {
+		const double day = 1440;
+		return std::make_unique<RegimeSwitchingGenerator>(std::vector<RegimeSwitchingGenerator::Regime>{
+			{0, volatility*0.5, 30*day},
+			{volatility, volatility, 14*day},
+			{-volatility, volatility*1.5, 7*day}
+		});
+	} else if (name == "bootstrap") {
+		if (source == nullptr) throw std::runtime_error("Bootstrap generator requires source series");
+		return std::make_unique<BootstrapGenerator>(*source);
+	} else {
+		throw std::runtime_error("Unknown price generator: "+name);
+	}
+}
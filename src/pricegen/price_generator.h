@@ -0,0 +1,152 @@
+/*
+ * price_generator.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_PRICEGEN_PRICE_GENERATOR_H_
+#define SRC_PRICEGEN_PRICE_GENERATOR_H_
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "price_series.h"
+
+///Random generator used by the price generators
+/**
+ * Distributions of the standard library are implementation defined, so the same seed
+ * can produce different series on different platforms. This generator uses only the raw
+ * output of the mt19937_64, which is fully specified, so the series are reproducible
+ * everywhere
+ */
+class PriceGenRandom {
+public:
+	explicit PriceGenRandom(std::uint64_t seed):rnd(seed) {}
+
+	///Uniform distribution in interval (0,1)
+	double uniform() {
+		return (static_cast<double>(rnd() >> 11) + 0.5) * (1.0/9007199254740992.0);
+	}
+	///Standard normal distribution
+	double normal();
+	///Uniform integer in interval [0, count)
+	std::size_t index(std::size_t count) {
+		return static_cast<std::size_t>(uniform() * count) % count;
+	}
+
+protected:
+	std::mt19937_64 rnd;
+	double spare = 0;
+	bool has_spare = false;
+};
+
+///Generates series of prices
+/**
+ * Each step of the generated series is one interval (usually one minute). Parameters
+ * of the models are annualized (drift 0.1 = +10% per year, volatility 0.8 = 80% per year)
+ */
+class IPriceGenerator {
+public:
+	///count of minutes per year, default interval
+	static constexpr double minutes_per_year = 525600;
+
+	virtual ~IPriceGenerator() {}
+	///Generates series
+	/**
+	 * @param start_price first price of the series
+	 * @param count count of prices
+	 * @param seed random seed - same seed generates same series
+	 * @param steps_per_year count of steps per year (default is one step per minute)
+	 * @return prices
+	 */
+	virtual std::vector<double> generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year = minutes_per_year) const = 0;
+};
+
+using PPriceGenerator = std::unique_ptr<IPriceGenerator>;
+
+///Geometric brownian motion
+class GBMGenerator: public IPriceGenerator {
+public:
+	GBMGenerator(double drift, double volatility):drift(drift),volatility(volatility) {}
+	virtual std::vector<double> generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year) const override;
+protected:
+	double drift;
+	double volatility;
+};
+
+///Merton jump diffusion - geometric brownian motion with random jumps
+class JumpDiffusionGenerator: public IPriceGenerator {
+public:
+	///Construct generator
+	/**
+	 * @param drift expected drift (jumps are compensated)
+	 * @param volatility volatility of the diffusion
+	 * @param intensity expected count of jumps per year
+	 * @param jump_mean mean of the logarithm of the jump
+	 * @param jump_stdev standard deviation of the logarithm of the jump
+	 */
+	JumpDiffusionGenerator(double drift, double volatility, double intensity, double jump_mean, double jump_stdev)
+		:drift(drift),volatility(volatility),intensity(intensity),jump_mean(jump_mean),jump_stdev(jump_stdev) {}
+	virtual std::vector<double> generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year) const override;
+protected:
+	double drift;
+	double volatility;
+	double intensity;
+	double jump_mean;
+	double jump_stdev;
+};
+
+///Geometric brownian motion, which switches parameters between regimes
+class RegimeSwitchingGenerator: public IPriceGenerator {
+public:
+	struct Regime {
+		double drift;
+		double volatility;
+		///expected duration of the regime in steps
+		double duration;
+	};
+	///Construct generator
+	/**
+	 * @param regimes list of regimes. When the regime ends, the next regime is picked
+	 * randomly from other regimes
+	 */
+	RegimeSwitchingGenerator(std::vector<Regime> regimes);
+	virtual std::vector<double> generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year) const override;
+protected:
+	std::vector<Regime> regimes;
+};
+
+///Generates series by resampling blocks of returns of recorded series
+/**
+ * Uses the stationary bootstrap - the series continues with the next recorded return, or
+ * with probability 1/block jumps to random position. The result preserves short-term
+ * structure (volatility clustering) of the recorded series
+ */
+class BootstrapGenerator: public IPriceGenerator {
+public:
+	///Construct generator
+	/**
+	 * @param source recorded series, must have same interval as the generated series
+	 * @param block expected length of the block
+	 */
+	BootstrapGenerator(const PriceSeries &source, double block = 1440);
+	virtual std::vector<double> generate(double start_price, std::size_t count, std::uint64_t seed, double steps_per_year) const override;
+protected:
+	std::vector<double> returns;
+	double block;
+};
+
+///Creates generator by name with default parameters
+/**
+ * @param name one of: gbm, jump, regime, bootstrap
+ * @param volatility annual volatility
+ * @param source source series for the bootstrap (can be null for other models)
+ * @return generator
+ * @exception std::runtime_error unknown name
+ */
+PPriceGenerator createPriceGenerator(const std::string &name, double volatility, const PriceSeries *source = nullptr);
+
+#endif /* SRC_PRICEGEN_PRICE_GENERATOR_H_ */
@@ -0,0 +1,161 @@
+/*
+ * price_series.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "price_series.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+static const char magic[4] = {'M','M','P','S'};
+static const std::uint32_t version = 1;
+
+template<typename T>
+static void writeLE(std::ostream &out, T val) {
+	unsigned char buff[sizeof(T)];
+	std::uint64_t v;
+	if constexpr(sizeof(T) == 8) std::memcpy(&v, &val, 8);
+	else {std::uint32_t w; std::memcpy(&w, &val, 4); v = w;}
+	for (std::size_t i = 0; i < sizeof(T); i++) buff[i] = static_cast<unsigned char>(v >> (i*8));
+	out.write(reinterpret_cast<const char *>(buff), sizeof(T));
+}
+
+template<typename T>
+static T readLE(std::istream &in) {
+	unsigned char buff[sizeof(T)];
+	if (!in.read(reinterpret_cast<char *>(buff), sizeof(T))) throw std::runtime_error("PriceSeries: unexpected end of file");
+	std::uint64_t v = 0;
+	for (std::size_t i = 0; i < sizeof(T); i++) v |= static_cast<std::uint64_t>(buff[i]) << (i*8);
+	T val;
+	if constexpr(sizeof(T) == 8) std::memcpy(&val, &v, 8);
+	else {std::uint32_t w = static_cast<std::uint32_t>(v); std::memcpy(&val, &w, 4);}
+	return val;
+}
+
+void PriceSeries::save(std::ostream &out) const {
+	out.write(magic, sizeof(magic));
+	writeLE<std::uint32_t>(out, version);
+	writeLE<std::uint64_t>(out, start_time);
+	writeLE<std::uint32_t>(out, interval);
+	writeLE<std::uint64_t>(out, prices.size());
+	if (prices.empty()) return;
+	writeLE<double>(out, prices[0]);
+	double lp = std::log(prices[0]);
+	for (std::size_t i = 1; i < prices.size(); i++) {
+		float d = static_cast<float>(std::log(prices[i]) - lp);
+		writeLE<float>(out, d);
+		lp += d;
+	}
+	if (!out) throw std::runtime_error("PriceSeries: write error");
+}
+
+PriceSeries PriceSeries::load(std::istream &in) {
+	char m[4];
+	if (!in.read(m, sizeof(m)) || std::memcmp(m, magic, sizeof(m)) != 0)
+		throw std::runtime_error("PriceSeries: invalid file format");
+	if (readLE<std::uint32_t>(in) != version)
+		throw std::runtime_error("PriceSeries: unsupported version");
+	PriceSeries res;
+	res.start_time = readLE<std::uint64_t>(in);
+	res.interval = readLE<std::uint32_t>(in);
+	std::uint64_t count = readLE<std::uint64_t>(in);
+	if (count == 0) return res;
+	res.prices.reserve(count);
+	double p0 = readLE<double>(in);
+	res.prices.push_back(p0);
+	double lp = std::log(p0);
+	for (std::uint64_t i = 1; i < count; i++) {
+		lp += readLE<float>(in);
+		res.prices.push_back(std::exp(lp));
+	}
+	return res;
+}
+
+void PriceSeries::saveFile(const std::string &fname) const {
+	std::ofstream f(fname, std::ios::out|std::ios::trunc|std::ios::binary);
+	if (!f) throw std::runtime_error("Can't create file: "+fname);
+	save(f);
+}
+
+PriceSeries PriceSeries::loadFile(const std::string &fname) {
+	std::ifstream f(fname, std::ios::in|std::ios::binary);
+	if (!f) throw std::runtime_error("Can't open file: "+fname);
+	return load(f);
+}
+
+std::string_view PriceSeries::trimValue(std::string_view v) {
+	while (!v.empty() && std::isspace(v.front())) v = v.substr(1);
+	while (!v.empty() && std::isspace(v.back())) v = v.substr(0, v.length()-1);
+	if (v.length() >= 2 && v.front() == '"' && v.back() == '"') v = v.substr(1, v.length()-2);
+	return v;
+}
+
+std::uint64_t PriceSeries::parseTime(std::string_view v) {
+	std::string s(v);
+	int y,m,d,h,mn;
+	double sec;
+	if (std::sscanf(s.c_str(), "%d-%d-%dT%d:%d:%lf", &y, &m, &d, &h, &mn, &sec) == 6) {
+		std::tm t = {};
+		t.tm_year = y - 1900;
+		t.tm_mon = m - 1;
+		t.tm_mday = d;
+		t.tm_hour = h;
+		t.tm_min = mn;
+		t.tm_sec = 0;
+		return static_cast<std::uint64_t>(timegm(&t))*1000 + static_cast<std::uint64_t>(sec * 1000);
+	}
+	return std::stoull(s);
+}
+
+PriceSeries PriceSeries::loadCSV(std::istream &in, std::uint32_t interval) {
+	if (interval == 0) throw std::runtime_error("PriceSeries: invalid interval");
+	std::vector<std::pair<std::uint64_t, double> > recs;
+	std::string line;
+	while (std::getline(in, line)) {
+		auto sep = line.find(',');
+		if (sep == line.npos) continue;
+		try {
+			std::string_view ln(line);
+			std::uint64_t tm = parseTime(trimValue(ln.substr(0, sep)));
+			double price = std::stod(std::string(trimValue(ln.substr(sep+1))));
+			if (price > 0 && std::isfinite(price) && (recs.empty() || recs.back().first < tm))
+				recs.emplace_back(tm, price);
+		} catch (std::exception &) {
+			//skip headers and invalid lines
+		}
+	}
+	PriceSeries res;
+	res.interval = interval;
+	if (recs.empty()) return res;
+	res.start_time = recs[0].first;
+	res.prices.push_back(recs[0].second);
+	std::uint64_t tm = res.start_time + interval;
+	for (std::size_t i = 1; i < recs.size(); i++) {
+		const auto &a = recs[i-1];
+		const auto &b = recs[i];
+		double la = std::log(a.second);
+		double lb = std::log(b.second);
+		double span = static_cast<double>(b.first - a.first);
+		while (tm <= b.first) {
+			double f = (tm - a.first)/span;
+			res.prices.push_back(std::exp(la + (lb - la)*f));
+			tm += interval;
+		}
+	}
+	return res;
+}
+
+PriceSeries PriceSeries::loadCSVFile(const std::string &fname, std::uint32_t interval) {
+	std::ifstream f(fname);
+	if (!f) throw std::runtime_error("Can't open file: "+fname);
+	return loadCSV(f, interval);
+}
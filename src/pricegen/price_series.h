@@ -0,0 +1,64 @@
+/*
+ * price_series.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_PRICEGEN_PRICE_SERIES_H_
+#define SRC_PRICEGEN_PRICE_SERIES_H_
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///Series of prices with fixed interval between prices
+struct PriceSeries {
+	///time of the first price (milliseconds)
+	std::uint64_t start_time = 0;
+	///interval between prices (milliseconds)
+	std::uint32_t interval = 60000;
+	///prices
+	std::vector<double> prices;
+
+	///Stores series in compact binary format
+	/**
+	 * Format: header (magic "MMPS", version, start time, interval, count, first price),
+	 * then one 32-bit float per price - difference of logarithm of the price. All values
+	 * are little endian. The differences are calculated against already rounded values,
+	 * so rounding errors don't accumulate. Relative error of each price is below 1e-7
+	 */
+	void save(std::ostream &out) const;
+	///Loads series stored by the function save()
+	static PriceSeries load(std::istream &in);
+
+	void saveFile(const std::string &fname) const;
+	static PriceSeries loadFile(const std::string &fname);
+
+	///Loads prices from CSV file and resamples them to given interval
+	/**
+	 * Each line contains time and price separated by comma (format of files in the
+	 * directory backtest). Time is either ISO 8601 string, or timestamp in milliseconds.
+	 * Prices between records are interpolated (logarithmically)
+	 *
+	 * @param in input stream
+	 * @param interval interval of the result
+	 * @return series
+	 */
+	static PriceSeries loadCSV(std::istream &in, std::uint32_t interval = 60000);
+	static PriceSeries loadCSVFile(const std::string &fname, std::uint32_t interval = 60000);
+
+	///Removes whitespaces and quotes around the value of the CSV column
+	static std::string_view trimValue(std::string_view v);
+	///Parses time of the CSV record - ISO 8601 string or timestamp in milliseconds
+	/**
+	 * @exception std::exception invalid time
+	 */
+	static std::uint64_t parseTime(std::string_view v);
+};
+
+
+
+#endif /* SRC_PRICEGEN_PRICE_SERIES_H_ */
@@ -661,11 +661,45 @@ function app_start(){
 		}) !== undefined;
 	}
 
-	function update() {
+	var report_state = null;
+	var report_api = true;
+
+	function fetch_report(wait) {
+		if (!report_api) return fetch_json("report.json?r="+Date.now());
+		var since = report_state?report_state.rev:0;
+		var url = "api/report?since="+since+(wait && since?"&wait=1":"")+"&r="+Date.now();
+		return fetch_json(url).then(function(delta) {
+			if (delta.full || !report_state) {
+				report_state = delta;
+			} else {
+				var st = Object.assign({}, report_state);
+				for (var k in delta) {
+					if (k == "charts" && delta.charts_partial) {
+						st.charts = Object.assign({}, st.charts, delta.charts);
+					} else if (k != "charts_partial") {
+						st[k] = delta[k];
+					}
+				}
+				report_state = st;
+			}
+			return report_state;
+		}, function(e) {
+			//delta api is not available, use static report
+			if (e.status == 404) {
+				report_api = false;
+				return fetch_report();
+			}
+			throw e;
+		});
+	}
+
+	function update(wait) {
 		
-		indicator.classList.remove("online");
-		indicator.classList.add("fetching");
-		return fetch_json("report.json?r="+Date.now()).then((stats)=>{
+		if (!wait) {
+			indicator.classList.remove("online");
+			indicator.classList.add("fetching");
+		}
+		return fetch_report(wait).then((stats)=>{
 
 			if (stats.rev != last_rev[0]) {
 				last_rev = [stats.rev, Date.now()];
@@ -956,10 +990,23 @@ function app_start(){
 	
 	var logo = document.getElementById("logo");
 	
+	//the server holds the request until next report is generated (long poll). When the
+	//report didn't change (error or static report), next request is sent after a minute
+	function poll() {
+		var rev = report_state && report_state.rev;
+		//no report for long time - the server is not generating reports
+		var outage = setTimeout(function() {indicator.classList.remove("online");}, 100000);
+		update(true).then(function() {
+			clearTimeout(outage);
+			var changed = report_api && report_state && report_state.rev != rev;
+			setTimeout(poll, changed?0:60000);
+		});
+	}
+
 	function removeLogo() {
 		update().then(function() {
 			logo.parentNode.removeChild(logo);
-			setInterval(update,60000);
+			poll();
 		});
 	}
 	